@@ -0,0 +1,288 @@
+// actor.cpp
+#include "actor.h"
+#include "linker.h"
+#include "executor.h"
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+// Messages one drain task processes before handing its worker back to the pool
+const size_t DRAIN_BATCH = 32;
+
+NodeResult failedResult(const std::string& errorMessage) {
+    NodeResult result;
+    result.output = {{"success", false}, {"error_message", errorMessage}};
+    return result;
+}
+
+} // namespace
+
+bool MailboxConfig::fromJson(const nlohmann::json& config, MailboxConfig& mailbox) {
+    try {
+        mailbox.capacity = config.value("capacity", static_cast<size_t>(0));
+        mailbox.spillDir = config.value("spill_dir", mailbox.spillDir);
+        std::string overflow = config.value("overflow", "block");
+        if (overflow == "block") {
+            mailbox.overflow = OverflowPolicy::Block;
+        } else if (overflow == "drop_oldest") {
+            mailbox.overflow = OverflowPolicy::DropOldest;
+        } else if (overflow == "reject") {
+            mailbox.overflow = OverflowPolicy::Reject;
+        } else if (overflow == "spill") {
+            mailbox.overflow = OverflowPolicy::Spill;
+        } else {
+            std::cerr << "NodeActor Error: Unknown queue overflow policy '" << overflow << "'." << std::endl;
+            return false;
+        }
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "NodeActor Error: Invalid queue configuration: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+NodeActor::NodeActor(NodeRef ref, const std::string& nodeId) : m_ref(ref), m_nodeId(nodeId) {
+}
+
+NodeActor::~NodeActor() {
+    if (m_spillFile.is_open()) {
+        m_spillFile.close();
+        std::error_code ignored;
+        std::filesystem::remove(m_spillPath, ignored);
+    }
+}
+
+void NodeActor::configure(const MailboxConfig& config) {
+    m_config = config;
+}
+
+bool NodeActor::post(ActorMessage message) {
+    const size_t capacity = m_config.capacity;
+    if (capacity > 0) {
+        switch (m_config.overflow) {
+        case OverflowPolicy::Reject:
+            if (queuedCount() >= capacity) {
+                std::cerr << "NodeActor Warning: Mailbox of '" << m_nodeId << "' is full; message rejected." << std::endl;
+                if (message.onReply) {
+                    message.onReply(failedResult("Rejected: mailbox of '" + m_nodeId + "' is full."));
+                }
+                return false;
+            }
+            break;
+        case OverflowPolicy::DropOldest:
+            if (queuedCount() >= capacity) {
+                // Producers cannot pop from the MPSC mailbox, so the drain discards it
+                m_toDrop.fetch_add(1, std::memory_order_acq_rel);
+            }
+            break;
+        case OverflowPolicy::Block: {
+            std::unique_lock<std::mutex> lock(m_spaceMutex);
+            if (queuedCount() >= capacity) {
+                // Lets the executor add a worker if this is a drain forwarding downstream
+                Executor::BlockingScope blocking;
+                m_spaceCv.wait(lock, [this, capacity] { return queuedCount() < capacity; });
+            }
+            // Enqueue while holding the lock, so two woken posters cannot both take the last slot
+            m_inMemory.fetch_add(1, std::memory_order_acq_rel);
+            m_mailbox.push(std::move(message));
+            schedule();
+            return true;
+        }
+        case OverflowPolicy::Spill: {
+            std::lock_guard<std::mutex> lock(m_spillMutex);
+            // Once anything is on disk, newer messages go there too, so order is kept
+            if (!m_spillReplies.empty() || queuedCount() >= capacity) {
+                if (spillWrite(message.data)) {
+                    m_spillReplies.push_back(std::move(message.onReply));
+                    schedule();
+                    return true;
+                }
+                // Disk unavailable: queue in memory beyond the capacity rather than lose the message
+            }
+            break;
+        }
+        }
+    }
+
+    m_inMemory.fetch_add(1, std::memory_order_acq_rel);
+    m_mailbox.push(std::move(message));
+    schedule();
+    return true;
+}
+
+void NodeActor::schedule() {
+    // Only the post that makes the mailbox non-empty schedules a drain; while a
+    // drain is running, it will pick this message up itself.
+    if (m_pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+        Executor::getInstance().submit([this] { drain(); });
+    }
+}
+
+size_t NodeActor::queuedCount() const {
+    size_t inMemory = m_inMemory.load(std::memory_order_acquire);
+    size_t toDrop = m_toDrop.load(std::memory_order_acquire);
+    return inMemory > toDrop ? inMemory - toDrop : 0;
+}
+
+void NodeActor::drain() {
+    Linker& linker = Linker::getInstance();
+    for (size_t processed = 0; processed < DRAIN_BATCH; ++processed) {
+        ActorMessage message;
+        bool readable = true;
+        // m_pending says a message exists. Memory holds the older messages; the
+        // spill file is only read once memory is empty.
+        for (;;) {
+            if (m_inMemory.load(std::memory_order_acquire) > 0) {
+                // A producer may still be linking it in
+                while (!m_mailbox.pop(message)) {
+                    std::this_thread::yield();
+                }
+                m_inMemory.fetch_sub(1, std::memory_order_acq_rel);
+                if (m_config.overflow == OverflowPolicy::Block && m_config.capacity > 0) {
+                    { std::lock_guard<std::mutex> lock(m_spaceMutex); }
+                    m_spaceCv.notify_one();
+                }
+                break;
+            }
+            std::lock_guard<std::mutex> lock(m_spillMutex);
+            if (!m_spillReplies.empty()) {
+                readable = spillRead(message.data);
+                message.onReply = std::move(m_spillReplies.front());
+                m_spillReplies.pop_front();
+                break;
+            }
+        }
+
+        // DropOldest: discard this message if a newer one claimed its place
+        size_t toDrop = m_toDrop.load(std::memory_order_acquire);
+        while (toDrop > 0 && !m_toDrop.compare_exchange_weak(toDrop, toDrop - 1, std::memory_order_acq_rel)) {
+        }
+
+        if (toDrop > 0) {
+            std::cerr << "NodeActor Warning: Mailbox of '" << m_nodeId << "' is full; oldest message dropped." << std::endl;
+            if (message.onReply) {
+                message.onReply(failedResult("Dropped: mailbox of '" + m_nodeId + "' overflowed."));
+            }
+        } else if (!readable) {
+            if (message.onReply) {
+                message.onReply(failedResult("Could not read spilled message of '" + m_nodeId + "'."));
+            }
+        } else if (message.schedule.deadline <= Schedule::Clock::now()) {
+            if (message.onReply) {
+                message.onReply(failedResult("Deadline exceeded."));
+            }
+        } else {
+            Schedule::Scope scheduleScope(message.schedule); // Subscribers inherit it as well
+            NodeResult result = linker.executeNode(m_ref, std::move(message.data));
+            deliver(message, result);
+        }
+
+        if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            return; // Mailbox empty; the next post schedules a new drain
+        }
+    }
+    // More messages are waiting: continue in a fresh task so other work can run.
+    Executor::getInstance().submit([this] { drain(); });
+}
+
+void NodeActor::deliver(const ActorMessage& message, const NodeResult& result) {
+    if (message.onReply) {
+        message.onReply(result);
+    }
+
+    std::vector<NodeRef> subscribers;
+    std::vector<OutputListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(m_subscriberMutex);
+        subscribers = m_subscribers;
+        listeners = m_listeners;
+    }
+
+    for (const OutputListener& listener : listeners) {
+        listener(m_nodeId, result);
+    }
+    if (!result.success) {
+        return; // Failed outputs are not forwarded downstream
+    }
+    for (NodeRef to : subscribers) {
+        // Node-to-node traffic: already admitted, but still subject to to's mailbox limits
+        Linker::getInstance().forward(to, result.output);
+    }
+}
+
+// Appends a length-prefixed CBOR record to the spill file
+bool NodeActor::spillWrite(const nlohmann::json& data) {
+    if (!m_spillFile.is_open()) {
+        std::error_code error;
+        std::filesystem::create_directories(m_config.spillDir, error);
+        m_spillPath = (std::filesystem::path(m_config.spillDir) / (m_nodeId + ".spill")).string();
+        m_spillFile.open(m_spillPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        m_spillReadOffset = 0;
+        if (!m_spillFile.is_open()) {
+            std::cerr << "NodeActor Error: Could not open spill file " << m_spillPath << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<std::uint8_t> bytes = nlohmann::json::to_cbor(data);
+    uint32_t length = static_cast<uint32_t>(bytes.size());
+    m_spillFile.clear();
+    m_spillFile.seekp(0, std::ios::end);
+    m_spillFile.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    m_spillFile.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    if (!m_spillFile) {
+        std::cerr << "NodeActor Error: Could not write spill file " << m_spillPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Reads the oldest spilled record; empties the file once everything is read
+bool NodeActor::spillRead(nlohmann::json& data) {
+    uint32_t length = 0;
+    std::vector<std::uint8_t> bytes;
+    m_spillFile.clear();
+    m_spillFile.seekg(static_cast<std::streamoff>(m_spillReadOffset));
+    m_spillFile.read(reinterpret_cast<char*>(&length), sizeof(length));
+    if (m_spillFile) {
+        bytes.resize(length);
+        m_spillFile.read(reinterpret_cast<char*>(bytes.data()), length);
+    }
+    bool ok = static_cast<bool>(m_spillFile);
+    m_spillReadOffset += sizeof(length) + length;
+
+    // The caller pops the last reply handler after this read
+    if (m_spillReplies.size() == 1) {
+        m_spillFile.close();
+        m_spillFile.open(m_spillPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        m_spillReadOffset = 0;
+    }
+
+    if (!ok) {
+        std::cerr << "NodeActor Error: Could not read spill file " << m_spillPath << std::endl;
+        return false;
+    }
+    try {
+        data = nlohmann::json::from_cbor(bytes);
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "NodeActor Error: Corrupt record in spill file " << m_spillPath << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void NodeActor::addSubscriber(NodeRef to) {
+    std::lock_guard<std::mutex> lock(m_subscriberMutex);
+    m_subscribers.push_back(to);
+}
+
+void NodeActor::addListener(OutputListener listener) {
+    std::lock_guard<std::mutex> lock(m_subscriberMutex);
+    m_listeners.push_back(std::move(listener));
+}
+
+size_t NodeActor::pendingCount() const {
+    return m_pending.load(std::memory_order_acquire);
+}
@@ -0,0 +1,127 @@
+#ifndef ACTOR_H
+#define ACTOR_H
+
+#include "node.h"
+#include "node_ref.h"
+#include "mailbox.h"
+#include "schedule.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A message waiting in a node's mailbox.
+struct ActorMessage {
+    nlohmann::json data;
+    // Called with this message's own result once the node has processed it
+    // (optional). Each sender gets the output of its own message, even though
+    // the node's m_data_out is overwritten by the next message.
+    std::function<void(const NodeResult&)> onReply;
+    // The sender's priority and deadline; the node runs the message (and its
+    // API requests) under them, or drops it if it is still queued at the
+    // deadline. Spilled messages fall back to the default.
+    Schedule schedule = Schedule::current();
+};
+
+// What post() does when a bounded mailbox is full.
+enum class OverflowPolicy {
+    Block,      // Wait for room. A full downstream mailbox stalls the upstream drain, so backpressure travels up the chain
+    DropOldest, // Accept the message and discard the oldest queued one (its sender gets a failed reply)
+    Reject,     // Refuse the new message (post() returns false, its sender gets a failed reply)
+    Spill       // Append to a file on disk and read it back in order once the mailbox has room
+};
+
+// Mailbox limits of one actor, from the "queue" section of an agent's JSON:
+// "queue": {"capacity": 64, "overflow": "block" | "drop_oldest" | "reject" | "spill", "spill_dir": "spill"}
+struct MailboxConfig {
+    size_t capacity = 0; // Messages queued in memory; 0 = unbounded
+    OverflowPolicy overflow = OverflowPolicy::Block;
+    std::string spillDir = "spill"; // Where Spill keeps its files
+
+    // Reads a "queue" object. Returns false (and logs) if it is malformed.
+    static bool fromJson(const nlohmann::json& config, MailboxConfig& mailbox);
+};
+
+// A NodeActor gives a registered Node an actor-style front end:
+// - Any thread may post() to it; posting pushes onto a lock-free MPSC mailbox.
+// - The first post into an empty mailbox schedules a drain task on the Executor.
+//   Only one drain runs at a time, so messages are processed one by one, in
+//   order, and the node never sees two concurrent senders.
+// - After each message the output goes to the sender's reply handler, to every
+//   subscribed node (as a new post), and to every output listener.
+// - The mailbox can be bounded (see MailboxConfig), which keeps memory and
+//   queueing delay in check when producers outpace the node.
+// A drain handles a bounded number of messages before yielding its worker, so
+// one busy node cannot monopolize the pool.
+class NodeActor {
+public:
+    using OutputListener = std::function<void(const std::string& fromId, const NodeResult& result)>;
+
+    NodeActor(NodeRef ref, const std::string& nodeId);
+    ~NodeActor();
+
+    // Delete copy constructor and assignment operator (owns a mailbox)
+    NodeActor(const NodeActor&) = delete;
+    NodeActor& operator=(const NodeActor&) = delete;
+
+    // Sets the mailbox limits. Call before messages are posted.
+    void configure(const MailboxConfig& config);
+
+    // Enqueues a message. Never blocks unless the mailbox is full under the
+    // Block policy. Returns false if the message was rejected.
+    bool post(ActorMessage message);
+
+    // Forwards every successful output of this node to another node's mailbox.
+    void addSubscriber(NodeRef to);
+    // Calls a listener with every output (successful or not) of this node.
+    void addListener(OutputListener listener);
+
+    // Messages posted but not yet fully processed (including spilled ones).
+    size_t pendingCount() const;
+
+private:
+    // Processes queued messages on an executor worker.
+    void drain();
+    // Counts a stored message and schedules a drain if none is running.
+    void schedule();
+    // Sends a result to the reply handler, subscribers and listeners.
+    void deliver(const ActorMessage& message, const NodeResult& result);
+    // Messages currently taking up capacity.
+    size_t queuedCount() const;
+
+    // Spill file helpers (m_spillMutex held). Return false on I/O errors.
+    bool spillWrite(const nlohmann::json& data);
+    bool spillRead(nlohmann::json& data);
+
+    const NodeRef m_ref;
+    const std::string m_nodeId;
+    MailboxConfig m_config;
+
+    MpscMailbox<ActorMessage> m_mailbox;
+    std::atomic<size_t> m_pending{0};  // Stored minus processed; 0 -> 1 schedules a drain
+    std::atomic<size_t> m_inMemory{0}; // Messages in m_mailbox (or being linked into it)
+    std::atomic<size_t> m_toDrop{0};   // Oldest messages the drain should discard (DropOldest)
+
+    // Block policy: posters wait here for room
+    std::mutex m_spaceMutex;
+    std::condition_variable m_spaceCv;
+
+    // Spill policy: payloads on disk, reply handlers (not serializable) in memory, both FIFO
+    std::mutex m_spillMutex;
+    std::fstream m_spillFile;
+    std::string m_spillPath;
+    uint64_t m_spillReadOffset = 0;
+    std::deque<std::function<void(const NodeResult&)>> m_spillReplies;
+
+    std::mutex m_subscriberMutex;
+    std::vector<NodeRef> m_subscribers;
+    std::vector<OutputListener> m_listeners;
+};
+
+#endif // ACTOR_H
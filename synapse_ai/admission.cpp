@@ -0,0 +1,64 @@
+// admission.cpp
+#include "admission.h"
+#include "executor.h"
+
+void AdmissionController::configure(size_t maxInFlight) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxInFlight = maxInFlight;
+    if (grantWaiting()) {
+        m_cv.notify_all();
+    }
+}
+
+bool AdmissionController::grantWaiting() {
+    bool granted = false;
+    Schedule::Clock::time_point now = Schedule::Clock::now();
+    while ((m_maxInFlight == 0 || m_inFlight < m_maxInFlight) && !m_waiting.empty()) {
+        m_granted.insert(m_waiting.topSequence(now));
+        uint64_t served;
+        m_waiting.pop(served, now);
+        ++m_inFlight; // Taken on the waiter's behalf
+        granted = true;
+    }
+    return granted;
+}
+
+void AdmissionController::acquire(const Schedule& schedule) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if ((m_maxInFlight == 0 || m_inFlight < m_maxInFlight) && m_waiting.empty()) {
+        ++m_inFlight;
+        return;
+    }
+    // Wait in line: release() hands each free slot to the most urgent waiter
+    Executor::BlockingScope blocking;
+    uint64_t ticket = m_waiting.push(0, schedule);
+    m_cv.wait(lock, [this, ticket] { return m_granted.count(ticket) > 0; });
+    m_granted.erase(ticket);
+}
+
+bool AdmissionController::tryAcquire() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if ((m_maxInFlight > 0 && m_inFlight >= m_maxInFlight) || !m_waiting.empty()) {
+        return false;
+    }
+    ++m_inFlight;
+    return true;
+}
+
+void AdmissionController::release() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_inFlight > 0) {
+            --m_inFlight;
+        }
+        if (!grantWaiting()) {
+            return;
+        }
+    }
+    m_cv.notify_all(); // The waiter granted the slot may be any of them
+}
+
+size_t AdmissionController::inFlight() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_inFlight;
+}
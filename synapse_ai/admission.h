@@ -0,0 +1,43 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include "deadline_queue.h"
+#include "schedule.h"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <unordered_set>
+
+// Global cap on requests in flight through the Linker's actor mode.
+// Work entering from outside (Linker::post/ask) takes a slot and gives it back
+// when its reply arrives; node-to-node forwarding is not counted again. When all
+// slots are taken, new callers wait, so overload shows up as backpressure at the
+// edge instead of as ever-growing queues inside. Waiting callers are admitted
+// in Schedule order, so an interactive request does not queue behind a batch job.
+class AdmissionController {
+public:
+    // 0 = unlimited (the default).
+    void configure(size_t maxInFlight);
+
+    // Takes a slot, waiting for one if the limit is reached.
+    void acquire(const Schedule& schedule = Schedule::current());
+    // Takes a slot if one is free. Returns false otherwise.
+    bool tryAcquire();
+    // Gives back a slot taken with acquire() or tryAcquire().
+    void release();
+
+    size_t inFlight() const;
+
+private:
+    size_t m_maxInFlight = 0;
+    size_t m_inFlight = 0;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    DeadlineQueue<uint64_t> m_waiting;   // Callers waiting in acquire(), by sequence number
+    std::unordered_set<uint64_t> m_granted; // Waiters handed a slot, not yet awake
+
+    // Hands free slots to the top waiters. Call with m_mutex held.
+    bool grantWaiting();
+};
+
+#endif // ADMISSION_H
@@ -27,32 +27,71 @@ const LLMParameters& Agent::getLLMParameters() const {
     return m_llmParams;
 }
 
-nlohmann::json Agent::pull() {
-	return m_data_out;
+const nlohmann::json& Agent::pull() {
+	return m_output.data();
 }
 
-// Agent's push method: Receives data (e.g., user prompt), prepares LLM request,
-// sends to ApiCommunicator via Linker, then pulls response.
-bool Agent::push(nlohmann::json data) {
-    m_data_in = data; // Store the incoming data (e.g., user prompt JSON)
-    std::string user_content;
+Message Agent::pullMessage() {
+    return m_output;
+}
+
+nlohmann::json Agent::saveState() const {
+    return {{"in", m_input.data()}, {"out", m_output.data()}};
+}
+
+bool Agent::loadState(const nlohmann::json& state) {
+    if (!state.is_object()) {
+        return false;
+    }
+    m_input = Message(state.value("in", nlohmann::json()));
+    m_output = Message(state.value("out", nlohmann::json()));
+    return true;
+}
+
+void Agent::setOutput(nlohmann::json payload) {
+    m_output = m_input.derive(m_id, std::move(payload));
+}
+
+// Stores the incoming message and extracts the prompt text from it
+bool Agent::readInput(Message message, std::string& user_content) {
+    m_input = std::move(message); // Store the incoming data (e.g., user prompt JSON)
+    const nlohmann::json& input = m_input.data(); // Shared with other recipients: read only
+    if (m_input.expired()) {
+        std::cerr << "Agent '" << m_id << "': Message deadline passed before processing; skipped." << std::endl;
+        setOutput({{"success", false}, {"error_message", "Deadline exceeded."}});
+        return false;
+    }
     // Ensure the incoming data has a "content" field (the actual user prompt)
-    if (m_data_in.contains("content") && m_data_in["content"].is_string()) { 
-    	user_content = m_data_in["content"].get<std::string>();
-    } else if (m_data_in.contains("generated_text") && m_data_in["generated_text"].is_string()) {
-    	user_content = m_data_in["generated_text"].get<std::string>();
+    if (input.contains("content") && input["content"].is_string()) { 
+    	user_content = input["content"].get<std::string>();
+    } else if (input.contains("generated_text") && input["generated_text"].is_string()) {
+    	user_content = input["generated_text"].get<std::string>();
     } else {
 	std::cerr << "Agent Error: Incoming data to push() does not contain a 'content' or 'generated_text' string." << std::endl;
-        // Set an error message in m_data_out so pull() can retrieve it
-        m_data_out = {{"success", false}, {"error_message", "Invalid input format to Agent push()."}};
-	std::cout << m_data_in << std::endl;
+        // Set an error message in the output so pull() can retrieve it
+        setOutput({{"success", false}, {"error_message", "Invalid input format to Agent push()."}});
+	std::cout << input << std::endl;
 	return false;
     }
+    return true;
+}
+
+bool Agent::push(nlohmann::json data) {
+    return pushMessage(Message(std::move(data)));
+}
+
+// Agent's push method: Receives data (e.g., user prompt), prepares LLM request,
+// sends to ApiCommunicator via Linker, then pulls response.
+bool Agent::pushMessage(Message message) {
+    std::string user_content;
+    if (!readInput(std::move(message), user_content)) {
+        return false;
+    }
 
     // 1. Prepare the JSON payload for ApiCommunicator
     // This payload contains all necessary info for the LLM API call
     nlohmann::json llm_request_payload = {
-        {"content", user_content},
+        {"content", std::move(user_content)},
         {"llm_params", {
             {"model", m_llmParams.model},
             {"instructions", m_llmParams.instructions},
@@ -60,36 +99,64 @@ bool Agent::push(nlohmann::json data) {
             {"topP", m_llmParams.topP},
             {"topK", m_llmParams.topK},
             {"maxOutputTokens", m_llmParams.maxOutputTokens},
-            {"maxHistoryTurns", m_llmParams.maxHistoryTurns}
+            {"maxHistoryTurns", m_llmParams.maxHistoryTurns},
+            {"backend", m_llmParams.backend}
         }}
     };
 
     std::cout << "Agent '" << m_id << "': Sending LLM request to ApiCommunicator via Linker." << std::endl;
 
     // 2. Send the LLM request payload to the ApiCommunicator Node via the Linker
-    bool send_success = Linker::getInstance().sendData("api_communicator", llm_request_payload);
+    Linker& linker = Linker::getInstance();
+    if (!m_apiCommunicator.valid()) {
+        m_apiCommunicator = linker.resolve("api_communicator");
+        if (!m_apiCommunicator.valid()) {
+            std::cerr << "Agent Error: Node 'api_communicator' is not registered." << std::endl;
+        }
+    }
+    bool send_success = m_apiCommunicator.valid() && linker.sendData(m_apiCommunicator, std::move(llm_request_payload));
 
     if (!send_success) {
         std::cerr << "Agent '" << m_id << "': Failed to send LLM request to ApiCommunicator via Linker." << std::endl;
-        m_data_out = {{"success", false}, {"error_message", "Failed to communicate with API."}};
+        setOutput({{"success", false}, {"error_message", "Failed to communicate with API."}});
         return false;
     }
 
     // 3. Pull the response from ApiCommunicator (assuming it has processed the request)
     // In a truly asynchronous system, this would involve a callback or event.
     // For synchronous push/pull Node model, we immediately pull.
-    m_data_out = ApiCommunicator::getInstance().pull();
+    // The response is shared with the ApiCommunicator rather than copied
+    m_output = m_input.derive(m_id, ApiCommunicator::getInstance().pullMessage().payload());
+    const nlohmann::json& output = m_output.data();
 
-    if (m_data_out.contains("success") && m_data_out["success"].is_boolean() && m_data_out["success"].get<bool>()) {
+    if (output.contains("success") && output["success"].is_boolean() && output["success"].get<bool>()) {
         std::cout << "Agent '" << m_id << "': Successfully received LLM response." << std::endl;
         return true;
     } else {
         std::cerr << "Agent '" << m_id << "': LLM response indicates failure or unexpected format." << std::endl;
-        std::cerr << "Raw API Communicator response: " << m_data_out.dump(2) << std::endl;
-        // m_data_out already contains error details from ApiCommunicator
+        std::cerr << "Raw API Communicator response: " << output.dump(2) << std::endl;
+        // The output already contains error details from ApiCommunicator
+        return false;
+    }
+}
+
+// Streaming variant of push(): the reply goes to onChunk piece by piece
+bool Agent::pushStreaming(nlohmann::json data, const ChunkCallback& onChunk) {
+    std::string user_content;
+    if (!readInput(Message(std::move(data)), user_content)) {
         return false;
     }
+
+    // The callback cannot travel through JSON, so this goes to the ApiCommunicator directly
+    std::cout << "Agent '" << m_id << "': Streaming LLM request to ApiCommunicator." << std::endl;
+    APIResponse response = ApiCommunicator::getInstance().generateContentStream(m_llmParams, std::move(user_content), onChunk);
+    if (!response.success) {
+        std::cerr << "Agent '" << m_id << "': Streamed LLM response indicates failure: " << response.errorMessage << std::endl;
+    }
+    const bool success = response.success;
+    setOutput(ApiCommunicator::responseToJson(std::move(response)));
+    return success;
 }
 
-// Node's pull method is inherited and implemented in node.cpp
-// It simply returns m_data_out
+// Agent keeps its input and output in m_input/m_output (shared Messages)
+// instead of Node's m_data_in/m_data_out
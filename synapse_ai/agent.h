@@ -2,6 +2,8 @@
 #define AGENT_H
 
 #include "node.h"
+#include "message.h"
+#include "node_ref.h"
 #include <nlohmann/json.hpp>
 #include <string>
 #include <map> // To store parameters if you want dynamic ones
@@ -15,6 +17,7 @@ struct LLMParameters {
     int maxOutputTokens;
     int maxHistoryTurns;
     std::string instructions;
+    std::string backend; // Name of a backend in base_config.json ("" = default_backend)
     // Add other relevant parameters as needed by the LLM API
 };
 
@@ -30,14 +33,34 @@ public:
     const std::string& getName() const;
     const LLMParameters& getLLMParameters() const; // Provides access to the parameters
 
-    nlohmann::json pull() override;
+    const nlohmann::json& pull() override;
     bool push(nlohmann::json data) override;
+    // Reads the prompt straight from the shared payload; the request is never copied.
+    bool pushMessage(Message message) override;
+    // The reply, shared: later hops and fan-out targets read it without copying.
+    Message pullMessage() override;
+    // Calls the streaming endpoint directly, so onChunk sees the reply while the
+    // model is still generating it.
+    bool pushStreaming(nlohmann::json data, const ChunkCallback& onChunk) override;
     bool requestContentGeneration();
 
+    // Last request and reply, for checkpoints.
+    nlohmann::json saveState() const override;
+    bool loadState(const nlohmann::json& state) override;
+
 private:
+    // Stores message in m_input and extracts its prompt text ("content" or "generated_text").
+    // On failure sets an error in m_output and returns false.
+    bool readInput(Message message, std::string& user_content);
+    // Replaces the output with payload, keeping the input's session/trace/deadline.
+    void setOutput(nlohmann::json payload);
+
     const std::string m_id;
     const std::string m_name;
     const LLMParameters m_llmParams; // Parameters specific to this agent
+    Message m_input;  // Last request (shared with the sender, read-only)
+    Message m_output; // Last reply (handed out shared by pullMessage())
+    NodeRef m_apiCommunicator; // Resolved on the first request; requests then route by handle
 };
 
 #endif // AGENT_H
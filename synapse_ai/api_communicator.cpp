@@ -1,5 +1,6 @@
 // src/api_communicator.cpp (Renamed from agent_manager.cpp)
 #include "api_communicator.h"
+#include "executor.h" // To mark workers blocked on HTTP
 #include <iostream>
 #include <fstream>
 #include <sstream> // For std::stringstream
@@ -7,17 +8,26 @@
 #include <cstdlib> // For std::getenv
 #include <algorithm> // For std::min
 
-// Initialize the static member buffer for cURL callback
-std::string ApiCommunicator::m_readBuffer;
+// Define the file holding the shared base configuration
+const std::string BASE_CONFIG_FILE = "base_config.json";
+const std::string DEFAULT_API_URL = "https://generativelanguage.googleapis.com/v1beta/models/";
+
+// Per-thread Node state: concurrent pushes from different threads (e.g. parallel
+// fan-out in the Linker) each see their own request and result.
+thread_local nlohmann::json ApiCommunicator::m_data_in;
+thread_local Message ApiCommunicator::m_data_out;
 
 // Private constructor implementation (Singleton)
-ApiCommunicator::ApiCommunicator() : m_curl(nullptr), m_headers(nullptr) {
-    // m_curl is initialized in initialize()
+ApiCommunicator::ApiCommunicator() : m_headers(nullptr), m_streamHeaders(nullptr), m_embedCurl(nullptr) {
+    // Until base_config.json is loaded, talk to the public Gemini endpoint directly
+    m_backends[m_defaultBackend].apiUrl = DEFAULT_API_URL;
+    // cURL handles are created in initialize() and on demand by acquireHandle()
     // curl_global_init() should be called only once globally, handled in initialize()
 }
 
 // Destructor implementation
 ApiCommunicator::~ApiCommunicator() {
+    stopEmbeddingBatcher(); // The batcher thread uses m_embedCurl, so stop it first
     cleanupCurl(); // Ensure cURL resources are cleaned up
 }
 
@@ -36,50 +46,186 @@ bool ApiCommunicator::initialize() {
         return false;
     }
 
-    // 2. Initialize cURL easy handle (call once, reuse thereafter)
-    m_curl = curl_easy_init();
-    if (!m_curl) {
+    // 2. Initialize the first cURL easy handle (reused thereafter).
+    // Further handles are created on demand when requests run concurrently.
+    CURL* curl = curl_easy_init();
+    if (!curl) {
         std::cerr << "curl_easy_init() failed." << std::endl;
         return false;
     }
+    m_idleHandles.push_back(curl);
 
-    // 3. Get API Key from environment variable
-    const char* apiKeyCStr = std::getenv("GEMINI_API_KEY");
-    if (apiKeyCStr == nullptr || std::string(apiKeyCStr).empty()) {
-        std::cerr << "ApiCommunicator Error: GEMINI_API_KEY environment variable not set. Please set it before running." << std::endl;
+    // 3. Get API Keys from the environment (GEMINI_API_KEY_FILE, GEMINI_API_KEYS or GEMINI_API_KEY)
+    if (!m_keyPool.loadFromEnvironment()) {
+        std::cerr << "ApiCommunicator Error: No API key found. Set GEMINI_API_KEY (or GEMINI_API_KEYS / GEMINI_API_KEY_FILE) before running." << std::endl;
         return false;
     }
-    m_apiKey = apiKeyCStr;
+    std::cout << "ApiCommunicator: Loaded " << m_keyPool.size() << " API key(s)." << std::endl;
 
-    // 4. Set static headers ONCE for the handle
-    // These headers will be reused for all requests.
-    // If curl_easy_reset() is used, these will need to be re-applied.
+    // 4. Build the static headers ONCE
+    // These headers are reused for all requests and re-applied after every curl_easy_reset().
     m_headers = curl_slist_append(m_headers, "Content-Type: application/json");
     m_headers = curl_slist_append(m_headers, "Accept: application/json");
-    curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, m_headers);
 
-    // Set common options here that don't change per request
-    curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &m_readBuffer);
+    // Streamed uploads use chunked encoding. An empty "Expect:" stops cURL from
+    // waiting for a "100 Continue" before it starts sending the body.
+    m_streamHeaders = curl_slist_append(m_streamHeaders, "Content-Type: application/json");
+    m_streamHeaders = curl_slist_append(m_streamHeaders, "Accept: application/json");
+    m_streamHeaders = curl_slist_append(m_streamHeaders, "Transfer-Encoding: chunked");
+    m_streamHeaders = curl_slist_append(m_streamHeaders, "Expect:");
+
     // Consider adding a timeout
-    // curl_easy_setopt(m_curl, CURLOPT_TIMEOUT, 30L); // 30 second timeout
+    // curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L); // 30 second timeout
+
+    // 5. Load shared settings (API URL, embedding batching limits).
+    // A missing base config is not fatal: built-in defaults are used instead.
+    loadBaseConfig();
+
+    // 6. Start the embedding batcher with its own handle, since cURL easy
+    // handles must not be shared between threads.
+    m_embedCurl = curl_easy_init();
+    if (!m_embedCurl) {
+        std::cerr << "curl_easy_init() failed for the embedding handle." << std::endl;
+        return false;
+    }
+    m_embedStop = false;
+    m_embedThread = std::thread(&ApiCommunicator::embeddingBatcherLoop, this);
 
     return true;
 }
 
+// Loads base_config.json and applies the settings the ApiCommunicator uses
+bool ApiCommunicator::loadBaseConfig() {
+    std::ifstream file(BASE_CONFIG_FILE);
+    if (!file.is_open()) {
+        std::cerr << "ApiCommunicator Warning: Could not open " << BASE_CONFIG_FILE << ". Using built-in defaults." << std::endl;
+        return false;
+    }
+
+    try {
+        file >> m_baseConfig;
+    } catch (const nlohmann::json::parse_error& e) {
+        std::cerr << "ApiCommunicator Warning: JSON parse error in " << BASE_CONFIG_FILE << ": " << e.what() << std::endl;
+        m_baseConfig = nlohmann::json::object();
+        return false;
+    }
+
+    try {
+        // Backends: the top-level api_url is the default backend's URL unless the
+        // "backends" section overrides it.
+        m_defaultBackend = m_baseConfig.value("default_backend", m_defaultBackend);
+        m_backends[m_defaultBackend].apiUrl = m_baseConfig.value("api_url", DEFAULT_API_URL);
+        if (m_baseConfig.contains("backends") && m_baseConfig["backends"].is_object()) {
+            for (const auto& [name, backend_json] : m_baseConfig["backends"].items()) {
+                BackendConfig& backend = m_backends[name];
+                backend.apiUrl = backend_json.value("api_url", backend.apiUrl.empty() ? DEFAULT_API_URL : backend.apiUrl);
+                backend.unixSocketPath = backend_json.value("unix_socket_path", "");
+                backend.proxy = backend_json.value("proxy", "");
+                backend.noProxy = backend_json.value("no_proxy", "");
+            }
+        }
+        if (!m_backends.count(m_defaultBackend)) {
+            std::cerr << "ApiCommunicator Warning: default_backend '" << m_defaultBackend << "' is not defined." << std::endl;
+        }
+        m_embeddingModel = m_baseConfig.value("default_embedding_model", m_embeddingModel);
+        m_embeddingMaxBatchSize = std::max<size_t>(1, m_baseConfig.value("embedding_max_batch_size", m_embeddingMaxBatchSize));
+        m_embeddingMaxWait = std::chrono::microseconds(m_baseConfig.value("embedding_max_wait_us", static_cast<long long>(m_embeddingMaxWait.count())));
+        m_streamUploadThreshold = m_baseConfig.value("streaming_upload_threshold_bytes", m_streamUploadThreshold);
+        m_streamUploadChunkSize = std::max<size_t>(1024, m_baseConfig.value("streaming_upload_chunk_bytes", m_streamUploadChunkSize));
+        m_streamUploadMaxChunks = std::max<size_t>(1, m_baseConfig.value("streaming_upload_max_chunks", m_streamUploadMaxChunks));
+        m_keyPool.configure(m_baseConfig.value("api_key_requests_per_minute", 0),
+                            std::chrono::milliseconds(m_baseConfig.value("api_key_cooldown_ms", 30000)));
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "ApiCommunicator Warning: Invalid field in " << BASE_CONFIG_FILE << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Looks up a backend by name
+const BackendConfig& ApiCommunicator::resolveBackend(const std::string& name) const {
+    auto it = m_backends.find(name.empty() ? m_defaultBackend : name);
+    if (it == m_backends.end()) {
+        std::cerr << "ApiCommunicator Warning: Unknown backend '" << name << "'. Using '" << m_defaultBackend << "'." << std::endl;
+        it = m_backends.find(m_defaultBackend);
+    }
+    return it->second;
+}
+
+// Applies the transport settings of a backend to a cURL handle
+void ApiCommunicator::applyBackendOptions(CURL* curl, const BackendConfig& backend) {
+    if (!backend.unixSocketPath.empty()) {
+        // The URL still selects host header and path, but no TCP connection is made.
+        curl_easy_setopt(curl, CURLOPT_UNIX_SOCKET_PATH, backend.unixSocketPath.c_str());
+    }
+    if (!backend.proxy.empty()) {
+        curl_easy_setopt(curl, CURLOPT_PROXY, backend.proxy.c_str());
+    }
+    if (!backend.noProxy.empty()) {
+        curl_easy_setopt(curl, CURLOPT_NOPROXY, backend.noProxy.c_str());
+    }
+}
+
+// Progress callback: a non-zero return makes cURL abort the transfer
+static int CancellationProgressCallback(void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    return static_cast<const CancellationToken*>(clientp)->cancelled() ? 1 : 0;
+}
+
+void ApiCommunicator::applyCancellation(CURL* curl, const CancellationToken& token) {
+    if (!token.cancellable()) {
+        return; // Keep the progress meter off for ordinary requests
+    }
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, CancellationProgressCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, const_cast<CancellationToken*>(&token));
+}
+
 // Cleans up cURL resources
 void ApiCommunicator::cleanupCurl() {
     if (m_headers) {
         curl_slist_free_all(m_headers); // Free headers
         m_headers = nullptr;
     }
-    if (m_curl) {
-        curl_easy_cleanup(m_curl); // Clean up CURL handle
-        m_curl = nullptr;
+    if (m_streamHeaders) {
+        curl_slist_free_all(m_streamHeaders);
+        m_streamHeaders = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_handleMutex);
+        for (CURL* curl : m_idleHandles) {
+            curl_easy_cleanup(curl); // Clean up CURL handles
+        }
+        m_idleHandles.clear();
+    }
+    if (m_embedCurl) {
+        curl_easy_cleanup(m_embedCurl);
+        m_embedCurl = nullptr;
     }
     curl_global_cleanup(); // Clean up libcurl's global resources
 }
 
+// Takes an idle easy handle (keeping its open connections) or creates a new one
+CURL* ApiCommunicator::acquireHandle() {
+    {
+        std::lock_guard<std::mutex> lock(m_handleMutex);
+        if (!m_idleHandles.empty()) {
+            CURL* curl = m_idleHandles.back();
+            m_idleHandles.pop_back();
+            return curl;
+        }
+    }
+    return curl_easy_init();
+}
+
+// Returns a handle to the idle pool
+void ApiCommunicator::releaseHandle(CURL* curl) {
+    if (!curl) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_handleMutex);
+    m_idleHandles.push_back(curl);
+}
+
 // Static callback function for cURL to write received data
 size_t ApiCommunicator::WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
     ((std::string*)userp)->append((char*)contents, size * nmemb);
@@ -89,25 +235,283 @@ size_t ApiCommunicator::WriteCallback(void* contents, size_t size, size_t nmemb,
 // Main method to generate content using the Gemini API
 APIResponse ApiCommunicator::generateContent(LLMParameters params, std::string content) {
     APIResponse response;
-    m_readBuffer.clear(); // Clear previous response data
+    std::string readBuffer; // Response data for this request only
+
+    // Each concurrent request gets its own easy handle from the pool.
+    CURL* curl = acquireHandle();
+    if (!curl) {
+        response.success = false;
+        response.errorMessage = "curl_easy_init() failed.";
+        return response;
+    }
 
     // Reset the cURL handle to clear previous options, but keep the handle itself.
     // This is more efficient than cleanup/re-init for each request.
-    curl_easy_reset(m_curl);
+    curl_easy_reset(curl);
 
     //Re-apply common options and headers after reset
-    curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &m_readBuffer);
-    curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, m_headers); // Re-apply the headers!
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, m_headers); // Re-apply the headers!
+
+    const BackendConfig& backend = resolveBackend(params.backend);
+    applyBackendOptions(curl, backend);
+
+    // Lets a join abort this request once its result is no longer needed
+    const CancellationToken cancellation = CancellationToken::current();
+    applyCancellation(curl, cancellation);
+
+    // Decide up front whether the body is large enough to be streamed; the text
+    // fields dominate the body size, so they are a good estimate.
+    const bool streamUpload = m_streamUploadThreshold >= 0 &&
+        static_cast<long long>(content.size() + params.instructions.size()) >= m_streamUploadThreshold;
+
+    // content and params are our own copies, so move the large strings into the body.
+    nlohmann::json request_body = buildRequestBody(params, content);
+
+    // Set POST data for this specific request.
+    // Small bodies are serialized once into json_payload; large ones are serialized
+    // chunk by chunk while cURL is already sending (bounded memory, earlier start).
+    std::string json_payload;
+    RequestBodyStream bodyStream(request_body, m_streamUploadChunkSize, m_streamUploadMaxChunks);
+    if (streamUpload) {
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, m_streamHeaders);
+        bodyStream.attach(curl);
+    } else {
+        json_payload = request_body.dump();
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_payload.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, json_payload.length()); // Important for POST requests
+    }
+
+    CURLcode res = CURLE_OK;
+    long http_code = 0;
 
-    std::string url = "https://generativelanguage.googleapis.com/v1beta/models/" + params.model + ":generateContent?key=" + m_apiKey;
+    // Send on the least-loaded key. If that key is throttled, it goes into cooldown
+    // and the request is retried on another key (at most once per key in the pool).
+    const size_t maxAttempts = std::max<size_t>(1, m_keyPool.size());
+    for (size_t attempt = 0; attempt < maxAttempts; ++attempt) {
+        if (cancellation.cancelled()) {
+            res = CURLE_ABORTED_BY_CALLBACK;
+            break;
+        }
+        int keyIndex = m_keyPool.acquire();
+        if (keyIndex < 0) {
+            releaseHandle(curl);
+            response.success = false;
+            response.errorMessage = "No API key available.";
+            return response;
+        }
+
+        std::string url = backend.apiUrl + params.model + ":generateContent?key=" + m_keyPool.key(keyIndex);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        readBuffer.clear();
+        if (streamUpload) {
+            bodyStream.start(); // Each attempt re-serializes from the first byte
+        }
+
+        {
+            // Lets the executor add a worker if every worker is waiting on HTTP
+            Executor::BlockingScope blocking;
+            res = curl_easy_perform(curl); // The longest part of the program and most prone to bottlenecks
+        }
+
+        http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        m_keyPool.release(keyIndex, res == CURLE_OK ? http_code : 0);
+
+        if (res != CURLE_OK || http_code != 429) {
+            break;
+        }
+    }
+
+    if (res == CURLE_ABORTED_BY_CALLBACK && cancellation.cancelled()) {
+        response.success = false;
+        response.errorMessage = "Cancelled.";
+    } else if (res == CURLE_ABORTED_BY_CALLBACK && streamUpload && bodyStream.failed()) {
+        response.success = false;
+        response.errorMessage = "Failed to serialize request body.";
+    } else if (res != CURLE_OK) {
+        response.success = false;
+        response.errorMessage = "cURL error: " + std::string(curl_easy_strerror(res));
+    } else {
+        response = parseGeminiResponse(readBuffer);
+        if (!response.success && response.errorMessage.empty()) {
+            // Generic error if parse failed and no specific error message from parseGeminiResponse
+            response.errorMessage = "API call failed with HTTP status code: " + std::to_string(http_code);
+            if (http_code != 200) {
+                 response.errorMessage += ". Raw response: " + readBuffer;
+            }
+        }
+    }
+
+    // Set after parsing, since parseGeminiResponse() builds a fresh APIResponse
+    response.httpStatusCode = http_code;
+    response.timings = captureTimings(curl);
+    releaseHandle(curl);
+    recordTransferStats(params.model, response.timings);
+
+    //logApiCall("N/A", json_payload, readBuffer, response); // agentId is not directly available here
 
-    nlohmann::json request_body = {
+    return response;
+}
+
+// State of one server-sent-events response while cURL is receiving it
+struct SseStream {
+    const ChunkCallback* onText = nullptr;
+    std::string pending; // Bytes after the last complete line
+    std::string text;    // All text delivered so far
+    std::string raw;     // Non-event lines (e.g. a JSON error body)
+    std::string errorMessage;
+};
+
+// Splits received bytes into lines and delivers the text of every "data:" event
+static size_t SseWriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    SseStream* stream = static_cast<SseStream*>(userp);
+    stream->pending.append(static_cast<char*>(contents), size * nmemb);
+
+    size_t lineStart = 0;
+    for (size_t newline = stream->pending.find('\n'); newline != std::string::npos;
+         newline = stream->pending.find('\n', lineStart)) {
+        std::string line = stream->pending.substr(lineStart, newline - lineStart);
+        lineStart = newline + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.compare(0, 5, "data:") != 0) {
+            stream->raw += line + "\n";
+            continue;
+        }
+
+        try {
+            nlohmann::json event = nlohmann::json::parse(line.substr(5));
+            if (event.contains("error")) {
+                stream->errorMessage = event["error"].value("message", "Unknown API error.");
+                continue;
+            }
+            if (!event.contains("candidates") || !event["candidates"].is_array() || event["candidates"].empty()) {
+                continue;
+            }
+            const auto& content = event["candidates"][0].value("content", nlohmann::json::object());
+            for (const auto& part : content.value("parts", nlohmann::json::array())) {
+                if (part.contains("text") && part["text"].is_string()) {
+                    const std::string& piece = part["text"].get_ref<const std::string&>();
+                    stream->text += piece;
+                    (*stream->onText)(piece);
+                }
+            }
+        } catch (const nlohmann::json::exception& e) {
+            stream->errorMessage = "JSON parsing error in stream event: " + std::string(e.what());
+        }
+    }
+    stream->pending.erase(0, lineStart);
+    return size * nmemb;
+}
+
+// Streams a response from the API, delivering text as it arrives
+APIResponse ApiCommunicator::generateContentStream(LLMParameters params, std::string content, const ChunkCallback& onText) {
+    APIResponse response;
+    SseStream stream;
+    stream.onText = &onText;
+
+    CURL* curl = acquireHandle();
+    if (!curl) {
+        response.success = false;
+        response.errorMessage = "curl_easy_init() failed.";
+        return response;
+    }
+    curl_easy_reset(curl);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, SseWriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &stream);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, m_headers);
+
+    const BackendConfig& backend = resolveBackend(params.backend);
+    applyBackendOptions(curl, backend);
+
+    const CancellationToken cancellation = CancellationToken::current();
+    applyCancellation(curl, cancellation);
+
+    // Streamed prompts are chained-node outputs, so the body is always sent in one piece
+    const std::string model = params.model;
+    std::string json_payload = buildRequestBody(params, content).dump();
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_payload.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, json_payload.length());
+
+    CURLcode res = CURLE_OK;
+    long http_code = 0;
+
+    // A 429 arrives before any event, so retrying on another key cannot repeat text
+    const size_t maxAttempts = std::max<size_t>(1, m_keyPool.size());
+    for (size_t attempt = 0; attempt < maxAttempts; ++attempt) {
+        if (cancellation.cancelled()) {
+            res = CURLE_ABORTED_BY_CALLBACK;
+            break;
+        }
+        int keyIndex = m_keyPool.acquire();
+        if (keyIndex < 0) {
+            releaseHandle(curl);
+            response.success = false;
+            response.errorMessage = "No API key available.";
+            return response;
+        }
+
+        std::string url = backend.apiUrl + model + ":streamGenerateContent?alt=sse&key=" + m_keyPool.key(keyIndex);
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        stream.pending.clear();
+        stream.raw.clear();
+
+        {
+            Executor::BlockingScope blocking;
+            res = curl_easy_perform(curl);
+        }
+
+        http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        m_keyPool.release(keyIndex, res == CURLE_OK ? http_code : 0);
+
+        if (res != CURLE_OK || http_code != 429) {
+            break;
+        }
+    }
+
+    if (res == CURLE_ABORTED_BY_CALLBACK && cancellation.cancelled()) {
+        response.success = false;
+        response.errorMessage = "Cancelled.";
+    } else if (res != CURLE_OK) {
+        response.success = false;
+        response.errorMessage = "cURL error: " + std::string(curl_easy_strerror(res));
+    } else if (http_code != 200) {
+        // Errors come back as a plain JSON body rather than as events
+        response = parseGeminiResponse(stream.raw + stream.pending);
+        if (response.errorMessage.empty()) {
+            response.errorMessage = "API call failed with HTTP status code: " + std::to_string(http_code);
+        }
+        response.success = false;
+    } else if (!stream.errorMessage.empty()) {
+        response.success = false;
+        response.errorMessage = stream.errorMessage;
+    } else if (stream.text.empty()) {
+        response.success = false;
+        response.errorMessage = "Stream ended without any generated text.";
+    } else {
+        response.success = true;
+    }
+    response.generatedText = std::move(stream.text);
+
+    response.httpStatusCode = http_code;
+    response.timings = captureTimings(curl);
+    releaseHandle(curl);
+    recordTransferStats(model, response.timings);
+    return response;
+}
+
+// Builds the JSON body shared by generateContent and streamGenerateContent
+nlohmann::json ApiCommunicator::buildRequestBody(LLMParameters& params, std::string& content) {
+    return {
         {"contents", nlohmann::json::array({
             {
                 {"parts", nlohmann::json::array({
                     {
-                        {"text", content}
+                        {"text", std::move(content)}
                     }
                 })}
             }
@@ -116,7 +520,7 @@ APIResponse ApiCommunicator::generateContent(LLMParameters params, std::string c
             {
                 {"parts", nlohmann::json::array({
                     {
-                        {"text", params.instructions}
+                        {"text", std::move(params.instructions)}
                     }
                 })}
             }
@@ -128,51 +532,240 @@ APIResponse ApiCommunicator::generateContent(LLMParameters params, std::string c
             {"maxOutputTokens", params.maxOutputTokens}
         }}
     };
+}
+
+// Embeds a single text through the micro-batcher
+EmbeddingResponse ApiCommunicator::embedContent(const std::string& text, const std::string& model) {
+    std::vector<std::future<EmbeddingResponse>> futures = enqueueEmbeddings({text}, model);
+    return futures.front().get();
+}
 
-    std::string json_payload = request_body.dump();
+// Embeds several texts through the micro-batcher, preserving input order
+std::vector<EmbeddingResponse> ApiCommunicator::batchEmbedContents(const std::vector<std::string>& texts, const std::string& model) {
+    std::vector<std::future<EmbeddingResponse>> futures = enqueueEmbeddings(texts, model);
+    std::vector<EmbeddingResponse> results;
+    results.reserve(futures.size());
+    for (auto& future : futures) {
+        results.push_back(future.get());
+    }
+    return results;
+}
 
-    // Set URL and POST data for this specific request
-    curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, json_payload.c_str());
-    curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, json_payload.length()); // Important for POST requests
+// Adds texts to the pending queue and wakes the batcher thread
+std::vector<std::future<EmbeddingResponse>> ApiCommunicator::enqueueEmbeddings(const std::vector<std::string>& texts, const std::string& model) {
+    std::vector<std::future<EmbeddingResponse>> futures;
+    futures.reserve(texts.size());
+
+    std::lock_guard<std::mutex> lock(m_embedMutex);
+    const auto now = std::chrono::steady_clock::now();
+    for (const std::string& text : texts) {
+        PendingEmbedding pending;
+        pending.model = model.empty() ? m_embeddingModel : model;
+        pending.text = text;
+        pending.enqueuedAt = now;
+        futures.push_back(pending.result.get_future());
+
+        if (!m_embedThread.joinable() || m_embedStop) {
+            // Not initialized (or shutting down): fail immediately instead of blocking forever.
+            EmbeddingResponse response;
+            response.errorMessage = "ApiCommunicator is not initialized; cannot embed content.";
+            pending.result.set_value(response);
+            continue;
+        }
+        m_embedQueue.push_back(std::move(pending));
+    }
+    m_embedCv.notify_one();
+    return futures;
+}
 
-    CURLcode res = curl_easy_perform(m_curl); // The longest part of the program and most prone to bottlenecks
+// Batcher thread: waits until a batch is full or the oldest pending text has
+// waited long enough, then sends everything it took in as few requests as possible.
+void ApiCommunicator::embeddingBatcherLoop() {
+    std::unique_lock<std::mutex> lock(m_embedMutex);
+    while (true) {
+        m_embedCv.wait(lock, [this] { return m_embedStop || !m_embedQueue.empty(); });
+        if (m_embedStop) {
+            break;
+        }
 
-    long http_code = 0;
-    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &http_code);
-    
-    response.httpStatusCode = http_code;
+        // Give other callers up to m_embeddingMaxWait (measured from the oldest
+        // pending text) to join this batch, unless it is already full.
+        const auto flushAt = m_embedQueue.front().enqueuedAt + m_embeddingMaxWait;
+        m_embedCv.wait_until(lock, flushAt, [this] {
+            return m_embedStop || m_embedQueue.size() >= m_embeddingMaxBatchSize;
+        });
+        if (m_embedStop) {
+            break;
+        }
 
-    if (res != CURLE_OK) {
-        response.success = false;
-        response.errorMessage = "cURL error: " + std::string(curl_easy_strerror(res));
-    } else {
-        response = parseGeminiResponse(m_readBuffer);
-        if (!response.success && response.errorMessage.empty()) {
-            // Generic error if parse failed and no specific error message from parseGeminiResponse
-            response.errorMessage = "API call failed with HTTP status code: " + std::to_string(http_code);
-            if (http_code != 200) {
-                 response.errorMessage += ". Raw response: " + m_readBuffer;
+        // Take up to one full batch and group it by model (one request per model).
+        std::map<std::string, std::vector<PendingEmbedding>> batches;
+        size_t taken = 0;
+        while (!m_embedQueue.empty() && taken < m_embeddingMaxBatchSize) {
+            PendingEmbedding pending = std::move(m_embedQueue.front());
+            m_embedQueue.pop_front();
+            batches[pending.model].push_back(std::move(pending));
+            ++taken;
+        }
+
+        // Perform the HTTP requests without holding the lock so callers can keep queueing.
+        lock.unlock();
+        for (auto& [model, batch] : batches) {
+            std::vector<std::string> texts;
+            texts.reserve(batch.size());
+            for (const PendingEmbedding& pending : batch) {
+                texts.push_back(pending.text);
+            }
+
+            std::vector<EmbeddingResponse> results = performEmbeddingRequest(model, texts);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                batch[i].result.set_value(std::move(results[i]));
             }
         }
+        lock.lock();
     }
 
-    //logApiCall("N/A", json_payload, m_readBuffer, response); // agentId is not directly available here
+    // Fail whatever is still queued so no caller blocks forever.
+    for (PendingEmbedding& pending : m_embedQueue) {
+        EmbeddingResponse response;
+        response.errorMessage = "ApiCommunicator shut down before the embedding was sent.";
+        pending.result.set_value(response);
+    }
+    m_embedQueue.clear();
+}
 
-    return response;
+// Stops and joins the batcher thread
+void ApiCommunicator::stopEmbeddingBatcher() {
+    {
+        std::lock_guard<std::mutex> lock(m_embedMutex);
+        m_embedStop = true;
+    }
+    m_embedCv.notify_all();
+    if (m_embedThread.joinable()) {
+        m_embedThread.join();
+    }
+}
+
+// Sends a single batchEmbedContents request. Always returns one response per text.
+std::vector<EmbeddingResponse> ApiCommunicator::performEmbeddingRequest(const std::string& model, const std::vector<std::string>& texts) {
+    std::vector<EmbeddingResponse> results(texts.size());
+    std::string readBuffer;
+
+    curl_easy_reset(m_embedCurl);
+    curl_easy_setopt(m_embedCurl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(m_embedCurl, CURLOPT_WRITEDATA, &readBuffer);
+    curl_easy_setopt(m_embedCurl, CURLOPT_HTTPHEADER, m_headers);
+
+    // Embeddings always go through the default backend
+    const BackendConfig& backend = resolveBackend("");
+    applyBackendOptions(m_embedCurl, backend);
+
+    int keyIndex = m_keyPool.acquire();
+    if (keyIndex < 0) {
+        for (EmbeddingResponse& result : results) {
+            result.errorMessage = "No API key available.";
+        }
+        return results;
+    }
+    std::string url = backend.apiUrl + model + ":batchEmbedContents?key=" + m_keyPool.key(keyIndex);
+
+    nlohmann::json requests = nlohmann::json::array();
+    for (const std::string& text : texts) {
+        requests.push_back({
+            {"model", "models/" + model},
+            {"content", {
+                {"parts", nlohmann::json::array({
+                    {
+                        {"text", text}
+                    }
+                })}
+            }}
+        });
+    }
+    std::string json_payload = nlohmann::json{{"requests", std::move(requests)}}.dump();
+
+    curl_easy_setopt(m_embedCurl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(m_embedCurl, CURLOPT_POSTFIELDS, json_payload.c_str());
+    curl_easy_setopt(m_embedCurl, CURLOPT_POSTFIELDSIZE, json_payload.length());
+
+    CURLcode res = curl_easy_perform(m_embedCurl);
+
+    long http_code = 0;
+    curl_easy_getinfo(m_embedCurl, CURLINFO_RESPONSE_CODE, &http_code);
+    m_keyPool.release(keyIndex, res == CURLE_OK ? http_code : 0);
+    recordTransferStats(model, captureTimings(m_embedCurl));
+
+    // Helper to fail every text in the batch with the same message
+    auto failAll = [&](const std::string& message) {
+        for (EmbeddingResponse& result : results) {
+            result.success = false;
+            result.errorMessage = message;
+            result.httpStatusCode = http_code;
+        }
+        return results;
+    };
+
+    if (res != CURLE_OK) {
+        return failAll("cURL error: " + std::string(curl_easy_strerror(res)));
+    }
+
+    try {
+        nlohmann::json parsed_json = nlohmann::json::parse(readBuffer);
+        if (parsed_json.contains("error")) {
+            return failAll(parsed_json["error"].value("message", "Unknown API error."));
+        }
+        if (!parsed_json.contains("embeddings") || !parsed_json["embeddings"].is_array() || parsed_json["embeddings"].size() != texts.size()) {
+            std::string message = "Unexpected embedding response format (HTTP " + std::to_string(http_code) + ").";
+            if (m_debuggingEnabled) {
+                message += "\nRaw Response: " + readBuffer;
+            }
+            return failAll(message);
+        }
+
+        const auto& embeddings = parsed_json["embeddings"];
+        for (size_t i = 0; i < texts.size(); ++i) {
+            results[i].httpStatusCode = http_code;
+            if (embeddings[i].contains("values") && embeddings[i]["values"].is_array()) {
+                results[i].values = embeddings[i]["values"].get<std::vector<float>>();
+                results[i].success = true;
+            } else {
+                results[i].errorMessage = "Embedding response entry has no 'values' array.";
+            }
+        }
+    } catch (const nlohmann::json::exception& e) {
+        return failAll("JSON parsing error: " + std::string(e.what()));
+    }
+    return results;
 }
 
 // Node's push method implementation for ApiCommunicator (used by ApiCommunicatorNode wrapper)
 bool ApiCommunicator::push(nlohmann::json data) {
-    m_data_in = data; // Store incoming data
+    m_data_in = std::move(data); // Store incoming data (reads below use m_data_in)
+    nlohmann::json& request = m_data_in;
+
+    // Embedding requests: {"type": "embed", "content": "...", "model": "..."(optional)}
+    if (request.value("type", "") == "embed") {
+        EmbeddingResponse response = embedContent(request.value("content", ""), request.value("model", ""));
+        nlohmann::json output;
+        output["success"] = response.success;
+        output["embedding"] = std::move(response.values);
+        output["error_message"] = response.errorMessage;
+        output["http_status_code"] = response.httpStatusCode;
+        m_data_out = Message(std::move(output));
+        return response.success;
+    }
 
-    // Extract parameters from the incoming JSON
-    std::string content = data.value("content", "");
+    // Extract parameters from the incoming JSON. The request is our own, so the
+    // prompt is moved out of it rather than copied.
+    std::string content;
+    if (request.contains("content") && request["content"].is_string()) {
+        content = std::move(request["content"].get_ref<std::string&>());
+    }
     LLMParameters params;
 
     // Safely extract LLM parameters, providing defaults or checking existence
-    if (data.contains("llm_params")) {
-        nlohmann::json llm_params_json = data["llm_params"];
+    if (request.contains("llm_params")) {
+        const nlohmann::json& llm_params_json = request["llm_params"];
         params.model = llm_params_json.value("model", "gemini-pro");
         params.instructions = llm_params_json.value("instructions","");
         params.temperature = llm_params_json.value("temperature", 0.7f);
@@ -180,29 +773,110 @@ bool ApiCommunicator::push(nlohmann::json data) {
         params.topK = llm_params_json.value("topK", 1);
         params.maxOutputTokens = llm_params_json.value("maxOutputTokens", 1024);
         params.maxHistoryTurns = llm_params_json.value("maxHistoryTurns", 5);
+        params.backend = llm_params_json.value("backend", "");
     } else {
         // Fallback to default LLMParameters if not provided
-        params = {"gemini-pro", 0.7f, 0.9f, 1, 1024, 5, ""};
+        params = {"gemini-pro", 0.7f, 0.9f, 1, 1024, 5, "", ""};
         std::cerr << "ApiCommunicator Warning: 'llm_params' not found in incoming JSON. Using default LLM parameters." << std::endl;
     }
     std::cout << "generating content..." << std::endl;
     // Call the core API generation logic
-    APIResponse response = generateContent(params, content);
+    APIResponse response = generateContent(std::move(params), std::move(content));
     std::cout << "content generated!" << std::endl;
     // Convert APIResponse to JSON for m_data_out
-    m_data_out = nlohmann::json();
-    m_data_out["success"] = response.success;
-    m_data_out["generated_text"] = response.generatedText;
-    m_data_out["error_message"] = response.errorMessage;
-    m_data_out["http_status_code"] = response.httpStatusCode;
+    const bool success = response.success;
+    m_data_out = Message(responseToJson(std::move(response)));
+
+    return success; // Return success status of the API call
+}
+
+nlohmann::json ApiCommunicator::responseToJson(APIResponse response) {
+    nlohmann::json output;
+    output["success"] = response.success;
+    output["generated_text"] = std::move(response.generatedText);
+    output["error_message"] = std::move(response.errorMessage);
+    output["http_status_code"] = response.httpStatusCode;
+    output["timings"] = {
+        {"namelookup_us", response.timings.namelookupUs},
+        {"connect_us", response.timings.connectUs},
+        {"appconnect_us", response.timings.appconnectUs},
+        {"pretransfer_us", response.timings.pretransferUs},
+        {"starttransfer_us", response.timings.starttransferUs},
+        {"total_us", response.timings.totalUs},
+        {"upload_bytes", response.timings.uploadBytes},
+        {"download_bytes", response.timings.downloadBytes}
+    };
+    return output;
+}
 
-    return response.success; // Return success status of the API call
+const nlohmann::json& ApiCommunicator::pull() {
+    return m_data_out.data();
 }
 
-nlohmann::json ApiCommunicator::pull() {
+Message ApiCommunicator::pullMessage() {
     return m_data_out;
 }
 
+// Reads cURL's timing breakdown and transfer sizes for the last request on a handle
+TransferTimings ApiCommunicator::captureTimings(CURL* curl) {
+    TransferTimings timings;
+    curl_off_t value = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &value) == CURLE_OK) timings.namelookupUs = value;
+    if (curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &value) == CURLE_OK) timings.connectUs = value;
+    if (curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &value) == CURLE_OK) timings.appconnectUs = value;
+    if (curl_easy_getinfo(curl, CURLINFO_PRETRANSFER_TIME_T, &value) == CURLE_OK) timings.pretransferUs = value;
+    if (curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &value) == CURLE_OK) timings.starttransferUs = value;
+    if (curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &value) == CURLE_OK) timings.totalUs = value;
+    if (curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &value) == CURLE_OK) timings.uploadBytes = value;
+    if (curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &value) == CURLE_OK) timings.downloadBytes = value;
+    return timings;
+}
+
+// Adds a request's timings to the aggregate for its model
+void ApiCommunicator::recordTransferStats(const std::string& model, const TransferTimings& timings) {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    TransferStats& stats = m_transferStats[model];
+    stats.requests++;
+    stats.sum.namelookupUs += timings.namelookupUs;
+    stats.sum.connectUs += timings.connectUs;
+    stats.sum.appconnectUs += timings.appconnectUs;
+    stats.sum.pretransferUs += timings.pretransferUs;
+    stats.sum.starttransferUs += timings.starttransferUs;
+    stats.sum.totalUs += timings.totalUs;
+    stats.sum.uploadBytes += timings.uploadBytes;
+    stats.sum.downloadBytes += timings.downloadBytes;
+    stats.maxTotalUs = std::max(stats.maxTotalUs, timings.totalUs);
+}
+
+std::map<std::string, TransferStats> ApiCommunicator::getTransferStats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_transferStats;
+}
+
+// Prints per-model averages. "server" is starttransfer - pretransfer, i.e. the time
+// spent waiting for the first byte once the request was sent.
+void ApiCommunicator::logTransferStats() const {
+    std::map<std::string, TransferStats> stats = getTransferStats();
+    std::cout << "\n--- Transfer Timings (averages, ms) ---" << std::endl;
+    for (const auto& [model, entry] : stats) {
+        if (entry.requests == 0) {
+            continue;
+        }
+        const double n = static_cast<double>(entry.requests) * 1000.0; // us -> ms average
+        std::cout << model << " (" << entry.requests << " requests)"
+                  << ": dns " << entry.sum.namelookupUs / n
+                  << ", connect " << entry.sum.connectUs / n
+                  << ", tls " << entry.sum.appconnectUs / n
+                  << ", pretransfer " << entry.sum.pretransferUs / n
+                  << ", server " << (entry.sum.starttransferUs - entry.sum.pretransferUs) / n
+                  << ", total " << entry.sum.totalUs / n
+                  << ", max total " << entry.maxTotalUs / 1000.0
+                  << ", up " << entry.sum.uploadBytes / entry.requests << " B"
+                  << ", down " << entry.sum.downloadBytes / entry.requests << " B" << std::endl;
+    }
+    std::cout << "---------------------------------------" << std::endl;
+}
+
 // Parses the JSON response from the Gemini API
 APIResponse ApiCommunicator::parseGeminiResponse(const std::string& jsonResponse) {
     APIResponse response;
@@ -210,11 +884,12 @@ APIResponse ApiCommunicator::parseGeminiResponse(const std::string& jsonResponse
         nlohmann::json parsed_json = nlohmann::json::parse(jsonResponse);
 
         if (parsed_json.contains("candidates") && parsed_json["candidates"].is_array() && !parsed_json["candidates"].empty()) {
-            const auto& candidate = parsed_json["candidates"][0]; // Get the first candidate
+            auto& candidate = parsed_json["candidates"][0]; // Get the first candidate
             if (candidate.contains("content") && candidate["content"].contains("parts") && candidate["content"]["parts"].is_array() && !candidate["content"]["parts"].empty()) {
-                const auto& part = candidate["content"]["parts"][0]; // Get the first part
+                auto& part = candidate["content"]["parts"][0]; // Get the first part
                 if (part.contains("text") && part["text"].is_string()) {
-                    response.generatedText = part["text"].get<std::string>();
+                    // The parsed document is discarded, so the text is moved out of it
+                    response.generatedText = std::move(part["text"].get_ref<std::string&>());
                     response.success = true;
                 }
             }
@@ -269,6 +944,10 @@ bool ApiCommunicator::getDebuggingMode() const {
     return m_debuggingEnabled;
 }
 
+const nlohmann::json& ApiCommunicator::getBaseConfig() const {
+    return m_baseConfig;
+}
+
 // Setter for debugging mode (if you want to enable/disable it dynamically)
 void ApiCommunicator::setDebuggingMode(bool enable) {
     m_debuggingEnabled = enable;
@@ -9,8 +9,49 @@
 #include <nlohmann/json.hpp> // For JSON parsing and generation
 #include <filesystem> // For iterating through directories (C++17)
 #include <functional> // For std::function
+#include <deque> // For the pending embedding queue
+#include <future> // For std::promise / std::future handed to embedding callers
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include "node.h"
 #include "agent.h"
+#include "api_key_pool.h"
+#include "request_body_stream.h"
+#include "cancellation.h"
+
+// Per-request transfer timings reported by cURL (CURLINFO_*_TIME_T).
+// All times are in microseconds from the start of the request, so e.g.
+// starttransfer - pretransfer is the time the server took to answer.
+struct TransferTimings {
+    long long namelookupUs = 0;    // DNS resolution finished
+    long long connectUs = 0;       // TCP connect finished
+    long long appconnectUs = 0;    // TLS handshake finished (0 for plain HTTP)
+    long long pretransferUs = 0;   // Request about to be sent
+    long long starttransferUs = 0; // First response byte received
+    long long totalUs = 0;         // Whole transfer
+    long long uploadBytes = 0;
+    long long downloadBytes = 0;
+};
+
+// Aggregated transfer timings for all requests made with one model.
+struct TransferStats {
+    unsigned long long requests = 0;
+    TransferTimings sum;        // Field-wise sum over all requests (divide by requests for the mean)
+    long long maxTotalUs = 0;   // Slowest request seen
+};
+
+// Transport settings for one LLM backend, read from the "backends" section of
+// base_config.json. A backend can be reached directly, through an HTTP(S)/SOCKS
+// proxy, or over a Unix domain socket (e.g. a local egress sidecar).
+struct BackendConfig {
+    std::string apiUrl;         // Base URL of the models endpoint, e.g. ".../v1beta/models/"
+    std::string unixSocketPath; // If set, connect through this socket instead of TCP (CURLOPT_UNIX_SOCKET_PATH)
+    std::string proxy;          // If set, CURLOPT_PROXY (e.g. "http://127.0.0.1:3128")
+    std::string noProxy;        // If set, CURLOPT_NOPROXY host list
+};
 
 // Structure to hold the result of an API call (renamed from AgentResponse)
 struct APIResponse {
@@ -18,11 +59,22 @@ struct APIResponse {
     std::string generatedText;
     std::string errorMessage;
     long httpStatusCode = 0; // HTTP status code from the API response
+    TransferTimings timings; // Network breakdown of the request that produced this response
+};
+
+// Structure to hold the result of an embedding call.
+// Every caller of embedContent() gets its own vector, even when the text was
+// sent to the API as part of a larger micro-batch.
+struct EmbeddingResponse {
+    bool success = false;
+    std::vector<float> values;
+    std::string errorMessage;
+    long httpStatusCode = 0; // HTTP status code of the (batched) request
 };
 
 // The ApiCommunicator is a singleton class responsible for:
 // - Managing the cURL library for API communication.
-// - Handling the API key.
+// - Handling the API keys (a pool of keys, see ApiKeyPool).
 // - Sending requests to the Google Gemini API.
 // - Parsing API responses.
 // - Logging API calls.
@@ -37,43 +89,151 @@ public:
 
     // Initializes the ApiCommunicator:
     // - Loads base configuration (e.g., API base URL).
-    // - Sets the API key from an environment variable.
+    // - Loads the API key pool from the environment.
     // - Initializes the cURL library.
     bool initialize(); // No longer loads agents
 
     // NEW: Sends a request to the API and returns the response.
     APIResponse generateContent(LLMParameters params, std::string content);
 
+    // Sends a request to the streaming endpoint (streamGenerateContent, server-sent
+    // events) and calls onText with each piece of text as soon as it arrives.
+    // The returned response holds the complete text, like generateContent().
+    // A throttled key is retried on another key before any text has been delivered.
+    APIResponse generateContentStream(LLMParameters params, std::string content, const ChunkCallback& onText);
+
+    // Converts a response to the JSON that push()/pull() exchange with nodes.
+    // Takes the response by value so its text can be moved into the JSON.
+    static nlohmann::json responseToJson(APIResponse response);
+
+    // Embeds a single text and blocks until its vector is available.
+    // Concurrent callers are accumulated into micro-batches that are sent through
+    // batchEmbedContents once embedding_max_batch_size texts are pending or the
+    // oldest one has waited embedding_max_wait_us (both from base_config.json).
+    // An empty model selects default_embedding_model.
+    EmbeddingResponse embedContent(const std::string& text, const std::string& model = "");
+
+    // Embeds several texts at once. The texts go through the same batcher as
+    // embedContent(), so they may share requests with other callers.
+    // Results are returned in the same order as the input texts.
+    std::vector<EmbeddingResponse> batchEmbedContents(const std::vector<std::string>& texts, const std::string& model = "");
+
     bool push(nlohmann::json data);
 
-    nlohmann::json pull();
+    // Output of this thread's last push(); valid until its next push().
+    const nlohmann::json& pull();
+    // Same output as a Message sharing the payload, so callers that keep the
+    // response (e.g. Agent) hold it without a copy.
+    Message pullMessage();
+    // Returns a snapshot of the transfer timings aggregated per model
+    // (generateContent and embedding requests alike).
+    std::map<std::string, TransferStats> getTransferStats() const;
+    // Prints the per-model averages of getTransferStats() to the console.
+    void logTransferStats() const;
+
     // Existing: Debugging settings getter
     bool getDebuggingMode() const;
     void setDebuggingMode(bool);
 
+    // Contents of base_config.json, for settings owned by other components.
+    const nlohmann::json& getBaseConfig() const;
+
 
 private:
     ApiCommunicator();
     ~ApiCommunicator();
 
-    std::string m_apiKey;
-    nlohmann::json m_data_in;
-    nlohmann::json m_data_out;
+    ApiKeyPool m_keyPool; // Keys requests are distributed across
+    // Node-style input/output, kept per thread so concurrent callers of
+    // push() followed by pull() never see each other's results.
+    static thread_local nlohmann::json m_data_in;
+    static thread_local Message m_data_out;
+
+    std::atomic<bool> m_debuggingEnabled{false}; // Flag to enable/disable debugging logs
 
-    bool m_debuggingEnabled = false; // Flag to enable/disable debugging logs
+    nlohmann::json m_baseConfig; // Contents of base_config.json (empty if it could not be loaded)
+    std::map<std::string, BackendConfig> m_backends; // Keyed by backend name
+    std::string m_defaultBackend = "gemini";
 
-    CURL* m_curl; // The cURL easy handle for making HTTP requests
+    // Idle cURL easy handles for generateContent. A handle is used by one request
+    // at a time; keeping it afterwards preserves its open connections.
+    std::vector<CURL*> m_idleHandles;
+    std::mutex m_handleMutex;
     curl_slist* m_headers;
-    static std::string m_readBuffer; // Static buffer to store API response data
+    curl_slist* m_streamHeaders; // m_headers plus the headers used for streamed (chunked) uploads
+    // --- Embedding micro-batching ---
+    // A text waiting to be embedded, together with the promise its caller waits on.
+    struct PendingEmbedding {
+        std::string model;
+        std::string text;
+        std::chrono::steady_clock::time_point enqueuedAt;
+        std::promise<EmbeddingResponse> result;
+    };
+
+    std::string m_embeddingModel = "text-embedding-004";
+    size_t m_embeddingMaxBatchSize = 32;
+    std::chrono::microseconds m_embeddingMaxWait{2000};
+
+    // --- Streaming uploads ---
+    // Requests whose text is at least this large are serialized straight into
+    // the socket through a RequestBodyStream instead of one big string (-1 = never).
+    long long m_streamUploadThreshold = 262144;
+    size_t m_streamUploadChunkSize = 65536;
+    size_t m_streamUploadMaxChunks = 4;
+
+    CURL* m_embedCurl; // Dedicated handle, only used by the batcher thread
+    std::deque<PendingEmbedding> m_embedQueue;
+    std::mutex m_embedMutex;
+    std::condition_variable m_embedCv;
+    std::thread m_embedThread;
+    bool m_embedStop = false;
+
+    // --- Transfer statistics ---
+    std::map<std::string, TransferStats> m_transferStats; // Keyed by model name
+    mutable std::mutex m_statsMutex;
 
     // Private helper methods
 
     // Initializes the cURL library.
     bool initCurl();
-    // Cleans up the cURL easy handle.
+    // Cleans up the cURL easy handles.
     void cleanupCurl();
 
-    // Callback function for cURL to write received data into m_readBuffer.
+    // Takes a handle from the idle pool, creating one if none is idle.
+    CURL* acquireHandle();
+    // Returns a handle taken with acquireHandle() to the idle pool.
+    void releaseHandle(CURL* curl);
+
+    // Loads base_config.json into m_baseConfig and applies the settings it contains.
+    bool loadBaseConfig();
+
+    // Returns the named backend, falling back to the default backend if the name is empty or unknown.
+    const BackendConfig& resolveBackend(const std::string& name) const;
+    // Applies a backend's transport options (socket path, proxy) to an easy handle.
+    // Must be called again after every curl_easy_reset().
+    static void applyBackendOptions(CURL* curl, const BackendConfig& backend);
+    // Makes a transfer abort (CURLE_ABORTED_BY_CALLBACK) once token is cancelled.
+    // token must outlive the transfer. Does nothing for the "none" token.
+    static void applyCancellation(CURL* curl, const CancellationToken& token);
+
+    // Queues texts for the batcher thread and returns the futures their results arrive on.
+    std::vector<std::future<EmbeddingResponse>> enqueueEmbeddings(const std::vector<std::string>& texts, const std::string& model);
+    // Body of the batcher thread: collects pending texts and flushes them as batches.
+    void embeddingBatcherLoop();
+    // Stops the batcher thread, failing any texts that are still queued.
+    void stopEmbeddingBatcher();
+    // Sends one batchEmbedContents request for texts that all use the same model.
+    std::vector<EmbeddingResponse> performEmbeddingRequest(const std::string& model, const std::vector<std::string>& texts);
+
+    // Reads the timing and size counters of the last transfer on a handle.
+    static TransferTimings captureTimings(CURL* curl);
+    // Adds one request's timings to the per-model aggregate.
+    void recordTransferStats(const std::string& model, const TransferTimings& timings);
+
+    // Builds the generateContent request body, moving the text out of params and content.
+    static nlohmann::json buildRequestBody(LLMParameters& params, std::string& content);
+
+    // Callback function for cURL to append received data to the std::string in userp.
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp);
 
     // Parses the JSON response from the Gemini API to extract the generated text.
@@ -23,18 +23,27 @@ public:
         // Delegates the push operation to the ApiCommunicator singleton.
         // Assumes ApiCommunicator's push method is designed to handle incoming data
         // (e.g., to initiate an LLM request).
-        return ApiCommunicator::getInstance().push(data);
+        return ApiCommunicator::getInstance().push(std::move(data));
     }
 
+    // The ApiCommunicator keeps its push/pull state per thread and uses one cURL
+    // handle per request, so the Linker does not need to serialize calls to it.
+    bool supportsConcurrentPush() const override { return true; }
+
     // Pulls data from the underlying ApiCommunicator singleton.
     // This method is called to retrieve processed data from this node.
-    nlohmann::json pull() override {
+    const nlohmann::json& pull() override {
         // Delegates the pull operation to the ApiCommunicator singleton.
         // Assumes ApiCommunicator's pull method retrieves the result of its processing
         // (e.g., the LLM's generated response).
         return ApiCommunicator::getInstance().pull();
     }
 
+    // The response shared with the ApiCommunicator, not copied.
+    Message pullMessage() override {
+        return ApiCommunicator::getInstance().pullMessage();
+    }
+
 private:
     std::string m_id; // Unique identifier for this node
 };
@@ -0,0 +1,202 @@
+// api_key_pool.cpp
+#include "api_key_pool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream> // For splitting comma-separated key lists
+#include <cstdlib> // For std::getenv
+#include <algorithm> // For std::max
+
+namespace {
+
+const std::chrono::seconds RATE_WINDOW(60);
+
+// Removes leading and trailing whitespace from a key
+std::string trim(const std::string& value) {
+    const char* whitespace = " \t\r\n";
+    size_t begin = value.find_first_not_of(whitespace);
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = value.find_last_not_of(whitespace);
+    return value.substr(begin, end - begin + 1);
+}
+
+// Splits a comma-separated list of keys
+std::vector<std::string> splitKeys(const std::string& list) {
+    std::vector<std::string> keys;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        keys.push_back(trim(item));
+    }
+    return keys;
+}
+
+} // namespace
+
+// Loads keys from GEMINI_API_KEY_FILE, GEMINI_API_KEYS or GEMINI_API_KEY (in that order)
+bool ApiKeyPool::loadFromEnvironment() {
+    std::vector<std::string> keys;
+
+    const char* keyFile = std::getenv("GEMINI_API_KEY_FILE");
+    if (keyFile != nullptr && *keyFile != '\0') {
+        std::ifstream file(keyFile);
+        if (!file.is_open()) {
+            std::cerr << "ApiKeyPool Error: Could not open key file " << keyFile << std::endl;
+            return false;
+        }
+        // One key per line; blank lines and lines starting with '#' are ignored.
+        std::string line;
+        while (std::getline(file, line)) {
+            line = trim(line);
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            for (const std::string& key : splitKeys(line)) {
+                keys.push_back(key);
+            }
+        }
+    } else {
+        const char* keyList = std::getenv("GEMINI_API_KEYS");
+        if (keyList == nullptr || *keyList == '\0') {
+            keyList = std::getenv("GEMINI_API_KEY");
+        }
+        if (keyList != nullptr) {
+            keys = splitKeys(keyList);
+        }
+    }
+
+    setKeys(keys);
+    return size() > 0;
+}
+
+// Replaces the pool contents
+void ApiKeyPool::setKeys(const std::vector<std::string>& keys) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_keys.clear();
+    for (const std::string& key : keys) {
+        if (key.empty()) {
+            continue;
+        }
+        KeyState state;
+        state.key = key;
+        m_keys.push_back(std::move(state));
+    }
+}
+
+// Sets the per-key quota and cooldown
+void ApiKeyPool::configure(int requestsPerMinute, std::chrono::milliseconds cooldown) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_requestsPerMinute = std::max(0, requestsPerMinute);
+    m_cooldown = cooldown;
+}
+
+size_t ApiKeyPool::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_keys.size();
+}
+
+void ApiKeyPool::pruneWindow(KeyState& state, std::chrono::steady_clock::time_point now) {
+    while (!state.recent.empty() && now - state.recent.front() >= RATE_WINDOW) {
+        state.recent.pop_front();
+    }
+}
+
+// Picks the least-loaded key that is neither cooling down nor at quota
+int ApiKeyPool::pickKey(std::chrono::steady_clock::time_point now,
+                        std::chrono::steady_clock::time_point& nextAvailable) {
+    int best = -1;
+    nextAvailable = std::chrono::steady_clock::time_point::max();
+
+    for (size_t i = 0; i < m_keys.size(); ++i) {
+        KeyState& state = m_keys[i];
+        pruneWindow(state, now);
+
+        // When this key could next be used
+        auto availableAt = now;
+        if (state.cooldownUntil > availableAt) {
+            availableAt = state.cooldownUntil;
+        }
+        if (m_requestsPerMinute > 0 && static_cast<int>(state.recent.size()) >= m_requestsPerMinute) {
+            availableAt = std::max(availableAt, state.recent.front() + RATE_WINDOW);
+        }
+        if (availableAt > now) {
+            nextAvailable = std::min(nextAvailable, availableAt);
+            continue;
+        }
+
+        // Least loaded: fewest in-flight requests, then fewest requests this minute
+        if (best < 0 ||
+            state.inFlight < m_keys[best].inFlight ||
+            (state.inFlight == m_keys[best].inFlight && state.recent.size() < m_keys[best].recent.size())) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+// Takes a usable key at once if nobody is waiting; otherwise queues by schedule
+// and waits until this request is the top waiter and a key is usable
+int ApiKeyPool::acquire(const Schedule& schedule) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_keys.empty()) {
+        return -1;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto nextAvailable = std::chrono::steady_clock::time_point::max();
+    int best = m_waiting.empty() ? pickKey(now, nextAvailable) : -1;
+    if (best < 0) {
+        uint64_t ticket = m_waiting.push(0, schedule, now);
+        while (true) {
+            now = std::chrono::steady_clock::now();
+            best = pickKey(now, nextAvailable);
+            if (best >= 0 && m_waiting.topSequence(now) == ticket) {
+                uint64_t served;
+                m_waiting.pop(served, now);
+                break;
+            }
+            // Every key is cooling down or at quota: wait for the earliest one
+            // (or a release). If a key is usable but another request is first
+            // in line, that request takes it and wakes the rest; the timeout
+            // covers aging changing the order in between.
+            if (best >= 0) {
+                m_available.wait_for(lock, std::chrono::milliseconds(10));
+            } else {
+                m_available.wait_until(lock, nextAvailable);
+            }
+        }
+        // The next waiter may find another usable key
+        m_available.notify_all();
+    }
+
+    KeyState& chosen = m_keys[best];
+    chosen.inFlight++;
+    chosen.recent.push_back(now);
+    chosen.totalRequests++;
+    return best;
+}
+
+const std::string& ApiKeyPool::key(int index) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_keys.at(index).key;
+}
+
+// Releases a key and applies a cooldown if the request was throttled
+void ApiKeyPool::release(int index, long httpStatusCode) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (index < 0 || static_cast<size_t>(index) >= m_keys.size()) {
+            return;
+        }
+        KeyState& state = m_keys[index];
+        state.inFlight = std::max(0, state.inFlight - 1);
+        if (httpStatusCode == 429) {
+            state.throttledCount++;
+            state.cooldownUntil = std::chrono::steady_clock::now() + m_cooldown;
+            std::cerr << "ApiKeyPool Warning: Key #" << index << " was throttled; cooling down for "
+                      << m_cooldown.count() << " ms." << std::endl;
+        }
+    }
+    m_available.notify_all();
+}
@@ -0,0 +1,82 @@
+#ifndef API_KEY_POOL_H
+#define API_KEY_POOL_H
+
+#include "deadline_queue.h"
+#include "schedule.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// The ApiKeyPool holds every API key the ApiCommunicator may use and decides
+// which one each request goes out on:
+// - Keys come from GEMINI_API_KEY_FILE (one key per line), or from a
+//   comma-separated GEMINI_API_KEYS / GEMINI_API_KEY environment variable.
+// - Each key tracks its in-flight requests and the requests it sent during the
+//   last minute, so a per-key requests-per-minute quota can be respected.
+// - A key that gets throttled (HTTP 429) is put in cooldown and skipped.
+// - acquire() picks the least-loaded usable key and blocks if none is usable.
+//   Blocked requests get keys in Schedule order (priority class, then
+//   earliest deadline, with aging), so when batch work has used up the quota
+//   the next free key goes to a waiting interactive request.
+class ApiKeyPool {
+public:
+    ApiKeyPool() = default;
+
+    // Delete copy constructor and assignment operator (owns a mutex)
+    ApiKeyPool(const ApiKeyPool&) = delete;
+    ApiKeyPool& operator=(const ApiKeyPool&) = delete;
+
+    // Loads keys from the environment. Returns false if no key was found.
+    bool loadFromEnvironment();
+
+    // Replaces the pool with the given keys (empty entries are ignored).
+    void setKeys(const std::vector<std::string>& keys);
+
+    // Sets the per-key quota (0 = unlimited) and how long a throttled key rests.
+    void configure(int requestsPerMinute, std::chrono::milliseconds cooldown);
+
+    size_t size() const;
+
+    // Reserves the least-loaded key that is neither cooling down nor over its
+    // per-minute quota, waiting until one becomes available (and every more
+    // urgent waiter has been served) if necessary.
+    // Returns the key's index, or -1 if the pool is empty.
+    int acquire(const Schedule& schedule = Schedule::current());
+
+    // Returns the key at the given index (valid until setKeys() is called again).
+    const std::string& key(int index) const;
+
+    // Releases a key reserved by acquire(). An HTTP 429 puts the key in cooldown.
+    void release(int index, long httpStatusCode);
+
+private:
+    // Accounting for a single key
+    struct KeyState {
+        std::string key;
+        int inFlight = 0;                                         // Requests currently using this key
+        std::deque<std::chrono::steady_clock::time_point> recent; // Request start times within the last minute
+        std::chrono::steady_clock::time_point cooldownUntil{};    // Key is skipped until this time
+        unsigned long long totalRequests = 0;
+        unsigned long long throttledCount = 0;
+    };
+
+    // Drops start times older than one minute from a key's window.
+    static void pruneWindow(KeyState& state, std::chrono::steady_clock::time_point now);
+    // The usable key to hand out next, or -1; sets nextAvailable to when the
+    // earliest unusable key frees up.
+    int pickKey(std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& nextAvailable);
+
+    std::vector<KeyState> m_keys;
+    int m_requestsPerMinute = 0; // 0 means no client-side quota
+    std::chrono::milliseconds m_cooldown{30000};
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_available;
+    // Requests waiting in acquire(), by sequence number; the top one goes next
+    DeadlineQueue<uint64_t> m_waiting;
+};
+
+#endif // API_KEY_POOL_H
@@ -0,0 +1,67 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// Blocking FIFO queue with a fixed capacity, used between pipeline stages.
+// - push() blocks while the queue is full, so a fast stage cannot run ahead of a
+//   slow one by more than the capacity (back-pressure).
+// - pop() blocks while the queue is empty.
+// - close() wakes everyone up: pushes fail from then on, and pops keep returning
+//   the remaining items before they fail too.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity > 0 ? capacity : 1) {}
+
+    // Delete copy constructor and assignment operator (owns a mutex)
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Appends an item, waiting for room. Returns false if the queue was closed.
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) {
+            return false;
+        }
+        m_items.push_back(std::move(value));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    // Removes the oldest item, waiting for one. Returns false once the queue is
+    // closed and empty.
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if (m_items.empty()) {
+            return false;
+        }
+        out = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    // Marks the end of the input.
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+
+private:
+    const size_t m_capacity;
+    std::deque<T> m_items;
+    bool m_closed = false;
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+};
+
+#endif // BOUNDED_QUEUE_H
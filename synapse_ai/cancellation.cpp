@@ -0,0 +1,46 @@
+// cancellation.cpp
+#include "cancellation.h"
+
+namespace {
+// Token of the innermost active Scope on this thread
+thread_local CancellationToken* t_currentToken = nullptr;
+}
+
+CancellationToken CancellationToken::create(const CancellationToken& parent) {
+    CancellationToken token;
+    token.m_state = std::make_shared<State>();
+    token.m_state->parent = parent.m_state;
+    return token;
+}
+
+void CancellationToken::cancel() {
+    if (m_state) {
+        m_state->cancelled.store(true, std::memory_order_release);
+    }
+}
+
+bool CancellationToken::cancelled() const {
+    for (const State* state = m_state.get(); state != nullptr; state = state->parent.get()) {
+        if (state->cancelled.load(std::memory_order_acquire)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+CancellationToken CancellationToken::current() {
+    return t_currentToken ? *t_currentToken : CancellationToken();
+}
+
+CancellationToken::Scope::Scope(const CancellationToken& token)
+    : m_token(token), m_previous(t_currentToken) {
+    if (m_token.cancellable()) {
+        t_currentToken = &m_token;
+    }
+}
+
+CancellationToken::Scope::~Scope() {
+    if (m_token.cancellable()) {
+        t_currentToken = m_previous;
+    }
+}
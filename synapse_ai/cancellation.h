@@ -0,0 +1,56 @@
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <atomic>
+#include <memory>
+
+// A CancellationToken lets one party tell running work that its result is no
+// longer needed (e.g. the losing branches of a first-K join).
+// - Copies share one flag; cancel() on any copy is seen by all of them.
+// - A default-constructed token is "none": it can never be cancelled.
+// - Work picks the token up through a Scope, which makes it the current token
+//   of the thread. Code deep in a call chain (e.g. the ApiCommunicator's
+//   transfer loop) checks CancellationToken::current() without the token
+//   having to be threaded through every JSON hop.
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    // A new token that can be cancelled. A token created with a parent is also
+    // cancelled when the parent is (e.g. a join nested in a cancelled branch).
+    static CancellationToken create(const CancellationToken& parent = CancellationToken());
+
+    void cancel();
+    bool cancelled() const;
+    // False for the "none" token.
+    bool cancellable() const { return m_state != nullptr; }
+
+    // The token installed on this thread (the "none" token if there is none).
+    static CancellationToken current();
+
+    // Installs a token as the thread's current token (see below).
+    class Scope;
+
+private:
+    struct State {
+        std::atomic<bool> cancelled{false};
+        std::shared_ptr<State> parent;
+    };
+    std::shared_ptr<State> m_state;
+};
+
+// Installs a token as the thread's current token for the scope's lifetime.
+// A "none" token keeps the enclosing one, so nested work is still cancelled
+// along with its caller.
+class CancellationToken::Scope {
+public:
+    explicit Scope(const CancellationToken& token);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    CancellationToken m_token;
+    CancellationToken* m_previous;
+};
+
+#endif // CANCELLATION_H
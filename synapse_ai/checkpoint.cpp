@@ -0,0 +1,459 @@
+// checkpoint.cpp
+#include "checkpoint.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// File header: identifies the format
+constexpr char MAGIC[8] = {'S', 'Y', 'N', 'C', 'K', 'P', 'T', '1'};
+// Record layout: uint32 length (of everything after it), uint16 key length,
+// key, CBOR value. The key sits outside the CBOR so restore() can index the
+// file without decoding superseded values.
+constexpr size_t LENGTH_BYTES = 4;
+constexpr size_t KEY_LENGTH_BYTES = 2;
+constexpr uint8_t CBOR_NULL = 0xf6;
+// Compaction is not worth it below this file size
+constexpr size_t MIN_COMPACTION_BYTES = 1024 * 1024;
+
+const std::string NODE_PREFIX = "node/";
+const std::string STEP_PREFIX = "step/";
+
+std::vector<uint8_t> encodeRecord(const std::string& key, const nlohmann::json& value) {
+    std::vector<uint8_t> bytes(LENGTH_BYTES + KEY_LENGTH_BYTES + key.size());
+    std::memcpy(bytes.data() + LENGTH_BYTES + KEY_LENGTH_BYTES, key.data(), key.size());
+    nlohmann::json::to_cbor(value, bytes); // Appends
+    uint32_t length = static_cast<uint32_t>(bytes.size() - LENGTH_BYTES);
+    uint16_t keyLength = static_cast<uint16_t>(key.size());
+    std::memcpy(bytes.data(), &length, sizeof(length));
+    std::memcpy(bytes.data() + LENGTH_BYTES, &keyLength, sizeof(keyLength));
+    return bytes;
+}
+
+bool writeAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+NodeResult stepResult(const nlohmann::json& value) {
+    NodeResult result;
+    result.success = value.value("success", false);
+    result.output = value.value("output", nlohmann::json());
+    return result;
+}
+
+} // namespace
+
+bool CheckpointConfig::fromJson(const nlohmann::json& config, CheckpointConfig& checkpoint) {
+    if (!config.is_object()) {
+        std::cerr << "Checkpointer Error: 'checkpoint' must be an object." << std::endl;
+        return false;
+    }
+    try {
+        checkpoint.enabled = config.value("enabled", checkpoint.enabled);
+        checkpoint.path = config.value("path", checkpoint.path);
+        checkpoint.interval = std::chrono::seconds(
+            config.value("interval_seconds", static_cast<long long>(checkpoint.interval.count())));
+        checkpoint.journalTtl = std::chrono::seconds(
+            config.value("journal_ttl_seconds", static_cast<long long>(checkpoint.journalTtl.count())));
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "Checkpointer Error: Invalid 'checkpoint' configuration: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+Checkpointer::Checkpointer(CheckpointConfig config)
+    : m_config(std::move(config)) {
+}
+
+Checkpointer::~Checkpointer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+bool Checkpointer::restore(const std::function<void(const std::string& nodeId, const nlohmann::json& state)>& applyNode) {
+    int fd = ::open(m_config.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return true; // First run: nothing to restore
+        }
+        std::cerr << "Checkpointer Error: Cannot open " << m_config.path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return true;
+    }
+    if (size < sizeof(MAGIC)) {
+        ::close(fd);
+        std::cerr << "Checkpointer Error: " << m_config.path << " is not a checkpoint file." << std::endl;
+        return false;
+    }
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Checkpointer Error: Cannot map " << m_config.path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    const uint8_t* const data = static_cast<const uint8_t*>(mapping);
+    if (std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        ::munmap(mapping, size);
+        std::cerr << "Checkpointer Error: " << m_config.path << " is not a checkpoint file." << std::endl;
+        return false;
+    }
+
+    // 1. Index: the latest record of every key, found from the record headers alone
+    std::unordered_map<std::string, std::pair<size_t, size_t>> latest; // key -> (offset, record size)
+    size_t offset = sizeof(MAGIC);
+    while (offset + LENGTH_BYTES + KEY_LENGTH_BYTES <= size) {
+        uint32_t length = 0;
+        uint16_t keyLength = 0;
+        std::memcpy(&length, data + offset, sizeof(length));
+        std::memcpy(&keyLength, data + offset + LENGTH_BYTES, sizeof(keyLength));
+        size_t recordSize = LENGTH_BYTES + length;
+        if (length < KEY_LENGTH_BYTES + keyLength + 1u || offset + recordSize > size) {
+            break; // Torn record at the end
+        }
+        std::string key(reinterpret_cast<const char*>(data + offset + LENGTH_BYTES + KEY_LENGTH_BYTES), keyLength);
+        const uint8_t* value = data + offset + LENGTH_BYTES + KEY_LENGTH_BYTES + keyLength;
+        size_t valueSize = length - KEY_LENGTH_BYTES - keyLength;
+        if (valueSize == 1 && *value == CBOR_NULL) {
+            latest.erase(key); // Deleted
+        } else {
+            latest[key] = {offset, recordSize};
+        }
+        offset += recordSize;
+    }
+    if (offset < size) {
+        std::cerr << "Checkpointer Warning: Dropping a torn record at the end of " << m_config.path << "." << std::endl;
+        m_needsCompaction = true;
+    }
+    m_fileBytes = offset;
+
+    // 2. Decode only the live values, straight from the mapping
+    size_t nodes = 0;
+    size_t steps = 0;
+    for (const auto& [key, location] : latest) {
+        const uint8_t* record = data + location.first;
+        uint16_t keyLength = 0;
+        std::memcpy(&keyLength, record + LENGTH_BYTES, sizeof(keyLength));
+        const uint8_t* value = record + LENGTH_BYTES + KEY_LENGTH_BYTES + keyLength;
+        nlohmann::json decoded;
+        try {
+            decoded = nlohmann::json::from_cbor(value, record + location.second);
+        } catch (const nlohmann::json::exception& e) {
+            std::cerr << "Checkpointer Warning: Skipping corrupt record '" << key << "': " << e.what() << std::endl;
+            m_needsCompaction = true;
+            continue;
+        }
+        m_live[key].assign(record, record + location.second);
+        m_liveBytes += location.second;
+
+        if (key.compare(0, NODE_PREFIX.size(), NODE_PREFIX) == 0) {
+            applyNode(key.substr(NODE_PREFIX.size()), decoded);
+            ++nodes;
+        } else if (key.compare(0, STEP_PREFIX.size(), STEP_PREFIX) == 0) {
+            size_t separator = key.find('/', STEP_PREFIX.size());
+            if (separator != std::string::npos) {
+                // Steps journaled before timestamps were recorded count as expired
+                JournaledRun& run = m_journal[key.substr(STEP_PREFIX.size(), separator - STEP_PREFIX.size())];
+                run.steps[key.substr(separator + 1)] = stepResult(decoded);
+                run.lastStep = std::max(run.lastStep, decoded.value("at", static_cast<int64_t>(0)));
+            }
+        }
+    }
+    ::munmap(mapping, size);
+
+    // Retries of runs this old are not expected: rewrite the file without them
+    if (dropExpiredRuns()) {
+        m_needsCompaction = true;
+    }
+    for (const auto& run : m_journal) {
+        steps += run.second.steps.size();
+    }
+    std::cout << "Checkpointer: Restored " << nodes << " node state(s) and " << steps << " journaled graph step(s) from "
+              << m_config.path << "." << std::endl;
+    return true;
+}
+
+void Checkpointer::start(std::function<void()> capture) {
+    m_capture = std::move(capture);
+    if (!openForAppend()) {
+        std::cerr << "Checkpointer Error: Cannot write " << m_config.path << "; checkpoints are not saved." << std::endl;
+    }
+    m_writer = std::thread(&Checkpointer::writerLoop, this);
+}
+
+void Checkpointer::saveNode(const std::string& nodeId, nlohmann::json state) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back({NODE_PREFIX + nodeId, std::move(state)});
+        ++m_queued;
+    }
+    m_wake.notify_one();
+}
+
+void Checkpointer::journalStep(const std::string& runKey, const std::string& stepId, const NodeResult& result) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        JournaledRun& run = m_journal[runKey];
+        int64_t now = nowSeconds();
+        if (!run.steps.empty() && expired(run.lastStep)) {
+            // Same run key as an expired run: start over rather than revive its steps
+            for (const auto& step : run.steps) {
+                m_queue.push_back({STEP_PREFIX + runKey + "/" + step.first, nullptr});
+                ++m_queued;
+            }
+            run.steps.clear();
+        }
+        run.steps[stepId] = result;
+        run.lastStep = now;
+        m_queue.push_back({STEP_PREFIX + runKey + "/" + stepId,
+                           {{"success", result.success}, {"output", result.output}, {"at", now}}});
+        ++m_queued;
+    }
+    m_wake.notify_one();
+}
+
+void Checkpointer::finishRun(const std::string& runKey) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_journal.find(runKey);
+        if (it == m_journal.end()) {
+            return;
+        }
+        for (const auto& step : it->second.steps) {
+            m_queue.push_back({STEP_PREFIX + runKey + "/" + step.first, nullptr});
+            ++m_queued;
+        }
+        m_journal.erase(it);
+    }
+    m_wake.notify_one();
+}
+
+std::map<std::string, NodeResult> Checkpointer::journaledSteps(const std::string& runKey) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_journal.find(runKey);
+    if (it == m_journal.end() || expired(it->second.lastStep)) {
+        return std::map<std::string, NodeResult>();
+    }
+    return it->second.steps;
+}
+
+bool Checkpointer::expired(int64_t lastStep) const {
+    return m_config.journalTtl.count() > 0 && lastStep + m_config.journalTtl.count() <= nowSeconds();
+}
+
+std::string Checkpointer::runKey(const std::string& graphId, uint64_t version, const nlohmann::json& input) {
+    uint64_t hash = std::hash<nlohmann::json>{}(input);
+    for (uint64_t part : {static_cast<uint64_t>(std::hash<std::string>{}(graphId)), version}) {
+        hash ^= part + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2); // boost::hash_combine style
+    }
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(hash));
+    return key;
+}
+
+void Checkpointer::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_writer.joinable()) {
+        return;
+    }
+    uint64_t target = m_queued;
+    m_wake.notify_one();
+    m_written.wait(lock, [this, target] { return m_done >= target; });
+}
+
+void Checkpointer::writerLoop() {
+    using Clock = std::chrono::steady_clock;
+    const bool periodic = m_config.interval.count() > 0 && m_capture;
+    Clock::time_point nextCapture = Clock::now() + m_config.interval;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        auto pending = [this] { return !m_queue.empty() || m_stopping; };
+        if (periodic) {
+            m_wake.wait_until(lock, nextCapture, pending);
+        } else {
+            m_wake.wait(lock, pending);
+        }
+        if (periodic && !m_stopping && Clock::now() >= nextCapture) {
+            // capture() queues records, which takes the lock
+            lock.unlock();
+            m_capture();
+            lock.lock();
+            nextCapture = Clock::now() + m_config.interval;
+        }
+
+        std::vector<Record> batch;
+        batch.swap(m_queue);
+        if (batch.empty()) {
+            if (m_stopping) {
+                break;
+            }
+            continue;
+        }
+        lock.unlock();
+        writeBatch(batch); // Encoding and I/O outside the lock
+        lock.lock();
+        m_done += batch.size();
+        m_written.notify_all();
+    }
+}
+
+void Checkpointer::writeBatch(std::vector<Record>& batch) {
+    std::vector<uint8_t> buffer;
+    for (Record& record : batch) {
+        if (record.key.size() > UINT16_MAX) {
+            std::cerr << "Checkpointer Error: Key too long; record dropped." << std::endl;
+            continue;
+        }
+        std::vector<uint8_t> bytes = encodeRecord(record.key, record.value);
+        buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+        auto live = m_live.find(record.key);
+        if (live != m_live.end()) {
+            m_liveBytes -= live->second.size();
+        }
+        if (record.value.is_null()) {
+            if (live != m_live.end()) {
+                m_live.erase(live);
+            }
+        } else {
+            m_liveBytes += bytes.size();
+            m_live[record.key] = std::move(bytes);
+        }
+    }
+
+    if (m_fd < 0 && !openForAppend()) {
+        return; // Logged; the live records are still written by the next compaction
+    }
+    if (!writeAll(m_fd, buffer.data(), buffer.size()) || ::fdatasync(m_fd) != 0) {
+        std::cerr << "Checkpointer Error: Writing " << m_config.path << " failed: " << std::strerror(errno) << std::endl;
+        m_needsCompaction = true; // The file may end in a partial record
+        ::close(m_fd);
+        m_fd = -1;
+        return;
+    }
+    m_fileBytes += buffer.size();
+
+    // Mostly superseded records: rewrite the file with the live ones only
+    if (m_fileBytes > MIN_COMPACTION_BYTES && m_fileBytes > 2 * (sizeof(MAGIC) + m_liveBytes)) {
+        compact();
+    }
+}
+
+bool Checkpointer::openForAppend() {
+    if (m_needsCompaction || m_fileBytes < sizeof(MAGIC)) {
+        return compact(); // Creates the file, or drops its torn tail
+    }
+    m_fd = ::open(m_config.path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (m_fd < 0) {
+        std::cerr << "Checkpointer Error: Cannot open " << m_config.path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Checkpointer::dropExpiredRuns() {
+    std::vector<std::string> keys;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_journal.begin(); it != m_journal.end();) {
+            if (!expired(it->second.lastStep)) {
+                ++it;
+                continue;
+            }
+            for (const auto& step : it->second.steps) {
+                keys.push_back(STEP_PREFIX + it->first + "/" + step.first);
+            }
+            it = m_journal.erase(it);
+        }
+    }
+    for (const std::string& key : keys) {
+        auto live = m_live.find(key);
+        if (live != m_live.end()) {
+            m_liveBytes -= live->second.size();
+            m_live.erase(live);
+        }
+    }
+    return !keys.empty();
+}
+
+bool Checkpointer::compact() {
+    dropExpiredRuns();
+
+    namespace fs = std::filesystem;
+    std::error_code error;
+    fs::path path(m_config.path);
+    if (path.has_parent_path()) {
+        fs::create_directories(path.parent_path(), error);
+    }
+
+    // Written next to the file, then renamed over it, so a crash leaves either
+    // the old or the new file
+    std::string temporary = m_config.path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Checkpointer Error: Cannot create " << temporary << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> buffer(MAGIC, MAGIC + sizeof(MAGIC));
+    buffer.reserve(sizeof(MAGIC) + m_liveBytes);
+    for (const auto& live : m_live) {
+        buffer.insert(buffer.end(), live.second.begin(), live.second.end());
+    }
+    bool ok = writeAll(fd, buffer.data(), buffer.size()) && ::fdatasync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(temporary.c_str(), m_config.path.c_str()) != 0) {
+        std::cerr << "Checkpointer Error: Rewriting " << m_config.path << " failed: " << std::strerror(errno) << std::endl;
+        ::unlink(temporary.c_str());
+        return false;
+    }
+
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd = ::open(m_config.path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    m_fileBytes = buffer.size();
+    m_needsCompaction = false;
+    return m_fd >= 0;
+}
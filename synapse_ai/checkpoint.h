@@ -0,0 +1,129 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "node.h"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Checkpoint settings, from the "checkpoint" section of base_config.json:
+// "checkpoint": {"enabled": true, "path": "checkpoints/state.ckpt", "interval_seconds": 30,
+//                "journal_ttl_seconds": 86400}
+struct CheckpointConfig {
+    bool enabled = false;
+    std::string path = "checkpoints/state.ckpt";
+    std::chrono::seconds interval{30}; // Periodic checkpoints; 0 = on demand only
+    // How long the journal of an unfinished (failed or interrupted) run is kept
+    // after its last step, for a retry; 0 = until the run finishes
+    std::chrono::seconds journalTtl{86400};
+
+    // Reads a "checkpoint" section. Returns false (and logs) if it is malformed.
+    static bool fromJson(const nlohmann::json& config, CheckpointConfig& checkpoint);
+};
+
+// Keeps node state and graph progress on disk so that a restart neither loses
+// the state nor repeats LLM calls that already completed.
+// - The file is a log of key/value records: a magic header, then records of
+//   a 4-byte length, a 2-byte key length, the key and the CBOR value. A later
+//   record for a key replaces the earlier one; a null value deletes the key.
+// - Writes are incremental and asynchronous: callers queue records, and a
+//   writer thread appends them in batches (one fdatasync per batch). When
+//   superseded records make up most of the file, it is rewritten with only
+//   the live ones and atomically renamed over the old file.
+// - restore() maps the file read-only, indexes it from the record headers
+//   and decodes only the latest value of each key, in place. A torn last
+//   record (a crash mid-write) is dropped.
+// Keys: "node/<nodeId>" holds a node's saveState(); "step/<runKey>/<stepId>"
+// holds a completed graph step's result until its run finishes or its journal
+// expires (see CheckpointConfig::journalTtl). Expired runs are ignored at once
+// and dropped from the file by restore() and by every compaction.
+class Checkpointer {
+public:
+    explicit Checkpointer(CheckpointConfig config);
+    // Writes everything queued, then stops the writer thread.
+    ~Checkpointer();
+
+    // Delete copy constructor and assignment operator (owns a thread and a file)
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    // Loads the checkpoint file (if any): calls applyNode for every saved node
+    // state and keeps the graph journal for journaledSteps(). Call once,
+    // before start(). Returns false (and logs) if the file is unusable.
+    bool restore(const std::function<void(const std::string& nodeId, const nlohmann::json& state)>& applyNode);
+    // Starts the writer thread. With an interval, it calls capture that often
+    // (capture queues the states that changed, e.g. Linker::checkpoint()).
+    void start(std::function<void()> capture);
+
+    // Queues a node's state.
+    void saveNode(const std::string& nodeId, nlohmann::json state);
+    // Queues a completed graph step.
+    void journalStep(const std::string& runKey, const std::string& stepId, const NodeResult& result);
+    // Drops a finished run's steps from the journal.
+    void finishRun(const std::string& runKey);
+    // The journaled steps of a run, keyed by step ID.
+    std::map<std::string, NodeResult> journaledSteps(const std::string& runKey) const;
+    // Identifies a graph run by its graph, the version of the graph and of its
+    // nodes' definitions, and its input, so that the same request after a
+    // restart finds the steps it already completed, but not once the graph or
+    // a node it uses was changed.
+    static std::string runKey(const std::string& graphId, uint64_t version, const nlohmann::json& input);
+
+    // Blocks until every record queued so far is on disk.
+    void flush();
+
+private:
+    struct Record {
+        std::string key;
+        nlohmann::json value; // null deletes the key
+    };
+    struct JournaledRun {
+        std::map<std::string, NodeResult> steps; // Step ID -> result
+        int64_t lastStep = 0;                    // When the last step was journaled (seconds since the epoch)
+    };
+
+    void writerLoop();
+    // Appends a batch to the file and keeps the live records up to date.
+    void writeBatch(std::vector<Record>& batch);
+    // Rewrites the file with only the live records, less expired runs.
+    // Returns false on failure.
+    bool compact();
+    // Drops the runs whose journal expired from the journal and the live
+    // records. Returns true if any was dropped.
+    bool dropExpiredRuns();
+    // True if the journal of a run whose last step was journaled at lastStep expired.
+    bool expired(int64_t lastStep) const;
+    // Opens the file for appending, creating it (with its header) if needed.
+    bool openForAppend();
+
+    const CheckpointConfig m_config;
+    std::function<void()> m_capture;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;    // Writer: records queued or stopping
+    std::condition_variable m_written; // flush(): a batch reached the disk
+    std::vector<Record> m_queue;
+    uint64_t m_queued = 0;             // Records ever queued
+    uint64_t m_done = 0;               // Records ever written (or dropped on an I/O error)
+    bool m_stopping = false;
+    std::thread m_writer;
+    // Graph journal by run key
+    std::unordered_map<std::string, JournaledRun> m_journal;
+
+    // Writer thread only (and restore(), before it starts)
+    int m_fd = -1;
+    std::unordered_map<std::string, std::vector<uint8_t>> m_live; // Encoded latest record per key
+    size_t m_liveBytes = 0;
+    size_t m_fileBytes = 0;
+    bool m_needsCompaction = false; // The file ends in a torn record
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,126 @@
+#ifndef DEADLINE_QUEUE_H
+#define DEADLINE_QUEUE_H
+
+#include "schedule.h"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+// Queue that serves items by Schedule (see schedule.h): most urgent class
+// first, earliest deadline first within a class, arrival order among equal
+// deadlines. Aging goes by the oldest item of each class: once it has waited
+// past the aging period, the class competes as a more urgent one and that
+// item goes first, so an old item behind a stream of earlier deadlines is
+// still served. Each class keeps its items ordered by deadline and by
+// arrival, so push() and pop() are O(log n) plus a look at each class.
+// Not synchronized: the owner guards it with its own mutex.
+template <typename T>
+class DeadlineQueue {
+public:
+    using Clock = Schedule::Clock;
+
+    // Queues an item. Returns its sequence number, which identifies it in topSequence().
+    uint64_t push(T value, const Schedule& schedule, Clock::time_point now = Clock::now()) {
+        Class& queue = m_classes[static_cast<size_t>(schedule.priority)];
+        uint64_t sequence = m_nextSequence++;
+        queue.byDeadline.emplace(schedule.deadline, sequence);
+        queue.byAge.emplace(now, sequence);
+        queue.entries.emplace(sequence, Entry{schedule, now, std::move(value)});
+        ++m_size;
+        return sequence;
+    }
+
+    // Removes the item to serve next. Returns false if the queue is empty.
+    bool pop(T& out, Clock::time_point now = Clock::now()) {
+        Candidate top = next(now);
+        if (top.index == PRIORITY_CLASSES) {
+            return false;
+        }
+        Class& queue = m_classes[top.index];
+        auto it = queue.entries.find(top.sequence);
+        queue.byDeadline.erase({it->second.schedule.deadline, top.sequence});
+        queue.byAge.erase({it->second.enqueued, top.sequence});
+        out = std::move(it->second.value);
+        queue.entries.erase(it);
+        --m_size;
+        return true;
+    }
+
+    // Sequence number of the item pop() would return. The queue must not be empty.
+    uint64_t topSequence(Clock::time_point now = Clock::now()) const {
+        return next(now).sequence;
+    }
+
+    // Most urgent class with an item queued (ignoring aging), or
+    // PRIORITY_CLASSES if the queue is empty.
+    size_t topClass() const {
+        for (size_t index = 0; index < PRIORITY_CLASSES; ++index) {
+            if (!m_classes[index].entries.empty()) {
+                return index;
+            }
+        }
+        return PRIORITY_CLASSES;
+    }
+
+    bool empty() const { return m_size == 0; }
+    size_t size() const { return m_size; }
+
+private:
+    using Key = std::pair<Clock::time_point, uint64_t>; // (time, sequence)
+
+    struct Entry {
+        Schedule schedule;
+        Clock::time_point enqueued;
+        T value;
+    };
+
+    struct Class {
+        std::map<uint64_t, Entry> entries; // By sequence number
+        std::set<Key> byDeadline;          // (deadline, sequence): earliest deadline, then oldest first
+        std::set<Key> byAge;               // (enqueued, sequence): longest waiting first
+    };
+
+    // The item a class offers and the class it competes in
+    struct Candidate {
+        size_t index = PRIORITY_CLASSES;
+        size_t effective = PRIORITY_CLASSES;
+        Key order;        // (deadline, sequence), to break ties between classes
+        uint64_t sequence = 0;
+    };
+
+    // The item to serve next (index PRIORITY_CLASSES if the queue is empty)
+    Candidate next(Clock::time_point now) const {
+        Candidate best;
+        for (size_t index = 0; index < PRIORITY_CLASSES; ++index) {
+            const Class& queue = m_classes[index];
+            if (queue.entries.empty()) {
+                continue;
+            }
+            Candidate candidate;
+            candidate.index = index;
+            const Key& oldest = *queue.byAge.begin();
+            const Entry& oldestEntry = queue.entries.find(oldest.second)->second;
+            candidate.effective = oldestEntry.schedule.effectiveClass(oldest.first, now);
+            if (candidate.effective < index) {
+                // Promoted by its oldest item, which goes before newer deadlines
+                candidate.sequence = oldest.second;
+                candidate.order = {oldestEntry.schedule.deadline, oldest.second};
+            } else {
+                candidate.order = *queue.byDeadline.begin();
+                candidate.sequence = candidate.order.second;
+            }
+            if (candidate.effective < best.effective ||
+                (candidate.effective == best.effective && candidate.order < best.order)) {
+                best = candidate;
+            }
+        }
+        return best;
+    }
+
+    Class m_classes[PRIORITY_CLASSES];
+    uint64_t m_nextSequence = 0;
+    size_t m_size = 0;
+};
+
+#endif // DEADLINE_QUEUE_H
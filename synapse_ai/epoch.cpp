@@ -0,0 +1,159 @@
+// epoch.cpp
+#include "epoch.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+// The calling thread's participant and ReadScope nesting depth. Plain values,
+// so ReadScopes keep working during static destruction (after ThreadExit ran).
+thread_local void* threadParticipant = nullptr;
+thread_local unsigned threadDepth = 0;
+thread_local bool threadExited = false;
+}
+
+struct EpochReclaimer::ThreadExit {
+    ~ThreadExit() {
+        if (auto* self = static_cast<Participant*>(threadParticipant)) {
+            self->epoch.store(0, std::memory_order_release);
+            self->inUse.store(false, std::memory_order_release); // Free for the next thread
+        }
+        threadParticipant = nullptr;
+        threadExited = true;
+    }
+};
+
+EpochReclaimer& EpochReclaimer::getInstance() {
+    static EpochReclaimer instance; // Guaranteed to be initialized once and destroyed correctly
+    return instance;
+}
+
+EpochReclaimer::~EpochReclaimer() {
+    for (Retired& retired : m_retired) {
+        retired.deleter();
+    }
+    Participant* participant = m_participants.load();
+    while (participant != nullptr) {
+        Participant* next = participant->next;
+        delete participant;
+        participant = next;
+    }
+}
+
+EpochReclaimer::Participant& EpochReclaimer::participant() {
+    if (threadParticipant != nullptr) {
+        return *static_cast<Participant*>(threadParticipant);
+    }
+    // Reuse the record of a thread that has exited, or add one
+    Participant* claimed = nullptr;
+    for (Participant* p = m_participants.load(std::memory_order_acquire); p != nullptr; p = p->next) {
+        bool expected = false;
+        if (!p->inUse.load(std::memory_order_relaxed) && p->inUse.compare_exchange_strong(expected, true)) {
+            claimed = p;
+            break;
+        }
+    }
+    if (claimed == nullptr) {
+        claimed = new Participant();
+        claimed->inUse.store(true, std::memory_order_relaxed);
+        claimed->next = m_participants.load(std::memory_order_relaxed);
+        while (!m_participants.compare_exchange_weak(claimed->next, claimed, std::memory_order_release,
+                                                     std::memory_order_relaxed)) {
+        }
+    }
+    threadParticipant = claimed;
+    if (!threadExited) {
+        // Release the record when the thread exits. (A thread already past its
+        // thread-local destructors keeps it; that is only the exiting main thread.)
+        static thread_local ThreadExit exitHook;
+        (void)exitHook;
+    }
+    return *claimed;
+}
+
+EpochReclaimer::ReadScope::ReadScope() {
+    if (threadDepth++ > 0) {
+        return; // Already pinned by an outer scope
+    }
+    EpochReclaimer& reclaimer = EpochReclaimer::getInstance();
+    Participant& self = reclaimer.participant();
+    self.epoch.store(reclaimer.m_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    // The pin must be visible before this thread loads any shared pointer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+EpochReclaimer::ReadScope::~ReadScope() {
+    if (--threadDepth > 0) {
+        return;
+    }
+    EpochReclaimer& reclaimer = EpochReclaimer::getInstance();
+    Participant& self = *static_cast<Participant*>(threadParticipant);
+    uint64_t pinned = self.epoch.load(std::memory_order_relaxed);
+    self.epoch.store(0, std::memory_order_release);
+    // This scope may have been what kept retired objects alive
+    if (pinned <= reclaimer.m_oldestRetired.load(std::memory_order_relaxed) &&
+        reclaimer.m_pending.load(std::memory_order_relaxed) > 0) {
+        reclaimer.reclaim();
+    }
+}
+
+void EpochReclaimer::retire(std::function<void()> deleter) {
+    {
+        std::lock_guard<std::mutex> lock(m_retiredMutex);
+        // Scopes that pin a later epoch opened after the object was unpublished
+        uint64_t epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst);
+        m_retired.push_back({epoch, std::move(deleter)});
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+        if (epoch < m_oldestRetired.load(std::memory_order_relaxed)) {
+            m_oldestRetired.store(epoch, std::memory_order_relaxed);
+        }
+    }
+    reclaim();
+}
+
+uint64_t EpochReclaimer::oldestPinned() const {
+    std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with the fence in ReadScope
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (Participant* p = m_participants.load(std::memory_order_acquire); p != nullptr; p = p->next) {
+        uint64_t pinned = p->epoch.load(std::memory_order_acquire);
+        if (pinned != 0 && pinned < oldest) {
+            oldest = pinned;
+        }
+    }
+    return oldest;
+}
+
+size_t EpochReclaimer::reclaim() {
+    std::vector<std::function<void()>> ready;
+    {
+        std::unique_lock<std::mutex> lock(m_retiredMutex, std::try_to_lock);
+        if (!lock.owns_lock() || m_retired.empty()) {
+            return 0; // Someone else is reclaiming
+        }
+        uint64_t oldest = oldestPinned();
+        uint64_t stillRetired = std::numeric_limits<uint64_t>::max();
+        size_t kept = 0;
+        for (Retired& retired : m_retired) {
+            if (retired.epoch < oldest) {
+                ready.push_back(std::move(retired.deleter));
+            } else {
+                stillRetired = std::min(stillRetired, retired.epoch);
+                if (&m_retired[kept] != &retired) {
+                    m_retired[kept] = std::move(retired);
+                }
+                ++kept;
+            }
+        }
+        m_retired.resize(kept);
+        m_pending.store(kept, std::memory_order_relaxed);
+        m_oldestRetired.store(stillRetired, std::memory_order_relaxed);
+    }
+    // Outside the lock: a destructor may retire something itself
+    for (auto& deleter : ready) {
+        deleter();
+    }
+    return ready.size();
+}
+
+size_t EpochReclaimer::pending() const {
+    return m_pending.load(std::memory_order_relaxed);
+}
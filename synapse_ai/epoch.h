@@ -0,0 +1,88 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Epoch-based reclamation for data that is read without locks (the Linker's
+// node registry). Readers wrap their use of a shared pointer in a ReadScope;
+// a writer publishes the replacement with an atomic store, then retire()s the
+// old object, which is deleted once every ReadScope that could still see it
+// has closed.
+// - A ReadScope costs one atomic store on entry and exit; nested scopes on the
+//   same thread are free.
+// - Reclamation runs on retire() and when the last pending scope closes; a
+//   long scope (a slow LLM call) only delays it.
+class EpochReclaimer {
+public:
+    // Static method to get the single instance of EpochReclaimer (Singleton pattern)
+    static EpochReclaimer& getInstance();
+
+    // Delete copy constructor and assignment operator to prevent copying
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+    // Pins the current epoch on this thread for the lifetime of the scope:
+    // nothing retired after the scope opened is deleted until it closes.
+    class ReadScope {
+    public:
+        ReadScope();
+        ~ReadScope();
+        ReadScope(const ReadScope&) = delete;
+        ReadScope& operator=(const ReadScope&) = delete;
+    };
+
+    // Deletes object once no ReadScope open now remains. The object must
+    // already be unreachable for new readers (its replacement published).
+    template <typename T>
+    void retire(T* object) {
+        if (object != nullptr) {
+            retire([object] { delete object; });
+        }
+    }
+    void retire(std::function<void()> deleter);
+
+    // Runs the deleters no reader can need any more. Returns how many ran.
+    size_t reclaim();
+    // Retired objects not deleted yet.
+    size_t pending() const;
+
+private:
+    EpochReclaimer() = default;
+    // Runs every remaining deleter (no readers are left at exit).
+    ~EpochReclaimer();
+
+    // One per thread that has opened a ReadScope; reused after the thread exits
+    struct Participant {
+        std::atomic<uint64_t> epoch{0}; // Pinned epoch; 0 when outside any scope
+        std::atomic<bool> inUse{false};
+        Participant* next = nullptr;
+    };
+
+    struct Retired {
+        uint64_t epoch; // Global epoch when it was retired
+        std::function<void()> deleter;
+    };
+
+    // Releases the thread's participant when the thread exits
+    struct ThreadExit;
+
+    // The calling thread's participant, claimed on first use
+    Participant& participant();
+    // Smallest epoch pinned by any thread, or UINT64_MAX if none is
+    uint64_t oldestPinned() const;
+
+    std::atomic<uint64_t> m_epoch{1};
+    std::atomic<Participant*> m_participants{nullptr}; // Push-only list
+    mutable std::mutex m_retiredMutex;
+    std::vector<Retired> m_retired;
+    std::atomic<size_t> m_pending{0};
+    // Oldest epoch among the retired objects, so a closing scope can tell
+    // cheaply whether it might have been holding reclamation up
+    std::atomic<uint64_t> m_oldestRetired{UINT64_MAX};
+};
+
+#endif // EPOCH_H
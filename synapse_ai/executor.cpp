@@ -0,0 +1,212 @@
+// executor.cpp
+#include "executor.h"
+#include <iostream>
+#include <algorithm> // For std::max
+
+namespace {
+
+// Index of the worker running on this thread, or -1 outside the pool
+thread_local long t_workerIndex = -1;
+// Nesting depth of BlockingScopes on this thread; only the outermost one counts
+thread_local int t_blockingDepth = 0;
+
+// Runs a task, keeping exceptions from escaping into the worker loop
+void runTask(Executor::Task& task, const Schedule& schedule) {
+    // Work the task submits or requests it makes inherit its schedule
+    Schedule::Scope scheduleScope(schedule);
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "Executor Error: Task threw an exception: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "Executor Error: Task threw an unknown exception." << std::endl;
+    }
+}
+
+} // namespace
+
+// Static method to get the single instance of Executor
+Executor& Executor::getInstance() {
+    static Executor instance; // Guaranteed to be initialized once and destroyed correctly
+    return instance;
+}
+
+// Starts one worker per core. Up to 16x that many may be added later to
+// compensate for workers blocked on I/O.
+Executor::Executor() {
+    size_t cores = std::max<unsigned>(1, std::thread::hardware_concurrency());
+    m_maxWorkers = std::max<size_t>(64, cores * 16);
+    m_workers.reset(new std::unique_ptr<Worker>[m_maxWorkers]);
+    for (size_t i = 0; i < cores; ++i) {
+        spawnWorker();
+    }
+}
+
+Executor::~Executor() {
+    m_stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_sleepCv.notify_all();
+
+    std::lock_guard<std::mutex> lock(m_spawnMutex);
+    size_t count = m_workerCount.load();
+    for (size_t i = 0; i < count; ++i) {
+        if (m_workers[i]->thread.joinable()) {
+            m_workers[i]->thread.join();
+        }
+    }
+}
+
+bool Executor::spawnWorker() {
+    std::lock_guard<std::mutex> lock(m_spawnMutex);
+    size_t index = m_workerCount.load();
+    if (index >= m_maxWorkers || m_stopping) {
+        return false;
+    }
+    m_workers[index] = std::make_unique<Worker>();
+    // Publish the slot before starting the thread so other workers can steal from it
+    m_workerCount.store(index + 1, std::memory_order_release);
+    m_workers[index]->thread = std::thread(&Executor::workerLoop, this, index);
+    return true;
+}
+
+size_t Executor::getWorkerCount() const {
+    return m_workerCount.load(std::memory_order_acquire);
+}
+
+bool Executor::isWorkerThread() const {
+    return t_workerIndex >= 0;
+}
+
+void Executor::submit(Task task) {
+    Schedule schedule = Schedule::current();
+    if (t_workerIndex >= 0) {
+        Worker& self = *m_workers[t_workerIndex];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        self.tasks.push_back({std::move(task), schedule});
+    } else {
+        std::lock_guard<std::mutex> lock(m_injectionMutex);
+        m_injectionQueue.push({std::move(task), schedule}, schedule);
+        m_injectedClass.store(m_injectionQueue.topClass(), std::memory_order_relaxed);
+    }
+    m_queuedTasks.fetch_add(1);
+
+    // Wake a sleeping worker (the lock pairs with the check in workerLoop)
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_sleepCv.notify_one();
+    compensateIfStarved();
+}
+
+bool Executor::tryTakeTask(size_t selfIndex, QueuedTask& task) {
+    // 1. Own deque, newest first, unless a more urgent class is waiting to be injected
+    if (selfIndex < m_workerCount.load(std::memory_order_acquire)) {
+        Worker& self = *m_workers[selfIndex];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (!self.tasks.empty() &&
+            static_cast<size_t>(self.tasks.back().schedule.priority) <= m_injectedClass.load(std::memory_order_relaxed)) {
+            task = std::move(self.tasks.back());
+            self.tasks.pop_back();
+            m_queuedTasks.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // 2. Injection queue, by class and deadline
+    {
+        std::lock_guard<std::mutex> lock(m_injectionMutex);
+        if (m_injectionQueue.pop(task)) {
+            m_injectedClass.store(m_injectionQueue.topClass(), std::memory_order_relaxed);
+            m_queuedTasks.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // 3. Own deque after all (the urgent task was taken by another worker)
+    if (selfIndex < m_workerCount.load(std::memory_order_acquire)) {
+        Worker& self = *m_workers[selfIndex];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (!self.tasks.empty()) {
+            task = std::move(self.tasks.back());
+            self.tasks.pop_back();
+            m_queuedTasks.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // 4. Steal the oldest task of another worker, starting after ourselves
+    size_t count = m_workerCount.load(std::memory_order_acquire);
+    for (size_t offset = 1; offset < count; ++offset) {
+        Worker& victim = *m_workers[(selfIndex + offset) % count];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (lock.owns_lock() && !victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queuedTasks.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Executor::workerLoop(size_t index) {
+    t_workerIndex = static_cast<long>(index);
+    QueuedTask task;
+    while (!m_stopping) {
+        if (tryTakeTask(index, task)) {
+            runTask(task.task, task.schedule);
+            task.task = nullptr;
+            continue;
+        }
+
+        // Nothing to run: sleep until a task is submitted. The timeout covers
+        // tasks that were skipped because a victim's lock was contended.
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepCv.wait_for(lock, std::chrono::milliseconds(10), [this] {
+            return m_stopping || m_queuedTasks.load() > 0;
+        });
+    }
+}
+
+bool Executor::runPendingTask() {
+    if (t_workerIndex < 0) {
+        return false;
+    }
+    QueuedTask task;
+    if (!tryTakeTask(static_cast<size_t>(t_workerIndex), task)) {
+        return false;
+    }
+    runTask(task.task, task.schedule);
+    return true;
+}
+
+void Executor::compensateIfStarved() {
+    if (m_queuedTasks.load() > 0 && m_blockedWorkers.load() >= m_workerCount.load()) {
+        spawnWorker();
+    }
+}
+
+Executor::BlockingScope::BlockingScope() : m_active(false) {
+    if (t_workerIndex < 0) {
+        return; // Not a pool thread: blocking here does not starve the pool
+    }
+    // Only the outermost scope on a worker counts it as blocked
+    m_active = (t_blockingDepth++ == 0);
+    if (m_active) {
+        Executor& executor = Executor::getInstance();
+        executor.m_blockedWorkers.fetch_add(1);
+        executor.compensateIfStarved();
+    }
+}
+
+Executor::BlockingScope::~BlockingScope() {
+    if (t_workerIndex < 0) {
+        return;
+    }
+    --t_blockingDepth;
+    if (m_active) {
+        Executor::getInstance().m_blockedWorkers.fetch_sub(1);
+    }
+}
@@ -0,0 +1,203 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include "deadline_queue.h"
+#include "schedule.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+// The Executor is a singleton work-stealing thread pool that runs node executions
+// for the Linker (fan-out, graph steps, ...):
+// - One worker per core, each with its own deque. A worker pushes and pops its own
+//   tasks at the back (LIFO, cache-warm) and steals from the front of others' deques.
+// - Tasks submitted from outside the pool go to a shared injection queue.
+// - Continuations (then()) are queued on the worker that produced the value.
+// - Node executions mostly wait on HTTP. Code that blocks wraps the wait in a
+//   BlockingScope; if every worker is blocked while work is queued, the pool adds
+//   a worker so CPU-side work keeps flowing.
+// - Every task runs under the Schedule (priority class and deadline) that was
+//   current where it was submitted. The injection queue is served by Schedule
+//   (see DeadlineQueue), and a worker takes a queued task of a more urgent
+//   class before its own deque, so interactive work does not wait behind a
+//   batch job's backlog.
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+    // Static method to get the single instance of Executor (Singleton pattern)
+    static Executor& getInstance();
+
+    // Delete copy constructor and assignment operator to prevent copying
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    // Queues a task: on the current worker's deque when called from a worker,
+    // otherwise on the injection queue. The task runs under the caller's
+    // current Schedule.
+    void submit(Task task);
+
+    // Runs f on the pool and returns a future for its result.
+    template <typename F>
+    auto async(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>;
+
+    // Runs f on the pool, then runs continuation(result of f) as a follow-up task
+    // on the same worker. Returns a future for the continuation's result.
+    template <typename F, typename C>
+    auto then(F&& f, C&& continuation);
+
+    // Waits for a future. On a worker thread the worker keeps running other tasks
+    // while it waits, so nested fan-outs cannot starve the pool.
+    template <typename T>
+    T await(std::future<T>& future);
+
+    // Number of worker threads currently in the pool.
+    size_t getWorkerCount() const;
+
+    // True if the calling thread is one of this pool's workers.
+    bool isWorkerThread() const;
+
+    // Marks the current worker as blocked (e.g. in curl_easy_perform) for the
+    // lifetime of the scope. Does nothing on threads outside the pool.
+    class BlockingScope {
+    public:
+        BlockingScope();
+        ~BlockingScope();
+        BlockingScope(const BlockingScope&) = delete;
+        BlockingScope& operator=(const BlockingScope&) = delete;
+    private:
+        bool m_active;
+    };
+
+private:
+    Executor();
+    ~Executor();
+
+    // A task and the Schedule it was submitted under
+    struct QueuedTask {
+        Task task;
+        Schedule schedule;
+    };
+
+    // A worker thread and its deque
+    struct Worker {
+        std::deque<QueuedTask> tasks;
+        std::mutex mutex;
+        std::thread thread;
+    };
+
+    // Starts another worker if below the limit. Returns false if the pool is full.
+    bool spawnWorker();
+    // Main loop of a worker thread.
+    void workerLoop(size_t index);
+    // Takes one task from: own deque (back), injection queue, other deques (front).
+    // A more urgent class waiting in the injection queue goes before the own deque.
+    bool tryTakeTask(size_t selfIndex, QueuedTask& task);
+    // Runs one queued task if there is one (used while waiting in await()).
+    bool runPendingTask();
+    // Adds a worker if all workers are blocked and work is waiting.
+    void compensateIfStarved();
+
+    size_t m_maxWorkers;
+    std::unique_ptr<std::unique_ptr<Worker>[]> m_workers; // Fixed slots, filled up to m_workerCount
+    std::atomic<size_t> m_workerCount{0};
+    std::mutex m_spawnMutex;
+
+    DeadlineQueue<QueuedTask> m_injectionQueue; // Tasks submitted from outside the pool
+    std::mutex m_injectionMutex;
+    // m_injectionQueue.topClass(), readable without the mutex
+    std::atomic<size_t> m_injectedClass{PRIORITY_CLASSES};
+
+    std::atomic<size_t> m_queuedTasks{0};    // Tasks waiting in any queue
+    std::atomic<size_t> m_blockedWorkers{0}; // Workers inside a BlockingScope
+    std::atomic<bool> m_stopping{false};
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCv;
+};
+
+template <typename F>
+auto Executor::async(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+    using Result = std::invoke_result_t<std::decay_t<F>>;
+    // std::function needs a copyable callable, so the packaged_task is shared
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+    std::future<Result> future = task->get_future();
+    submit([task] { (*task)(); });
+    return future;
+}
+
+template <typename F, typename C>
+auto Executor::then(F&& f, C&& continuation) {
+    using First = std::invoke_result_t<std::decay_t<F>>;
+    using Result = typename std::conditional_t<std::is_void_v<First>,
+                                               std::invoke_result<std::decay_t<C>>,
+                                               std::invoke_result<std::decay_t<C>, First>>::type;
+    auto promise = std::make_shared<std::promise<Result>>();
+    std::future<Result> future = promise->get_future();
+
+    submit([this, f = std::forward<F>(f), continuation = std::forward<C>(continuation), promise]() mutable {
+        // Runs f and builds the follow-up task. f's value is held in a shared_ptr
+        // so the follow-up stays copyable for std::function.
+        auto step = [&]() -> Task {
+            if constexpr (std::is_void_v<First>) {
+                f();
+                return [continuation, promise]() mutable {
+                    try {
+                        if constexpr (std::is_void_v<Result>) {
+                            continuation();
+                            promise->set_value();
+                        } else {
+                            promise->set_value(continuation());
+                        }
+                    } catch (...) {
+                        promise->set_exception(std::current_exception());
+                    }
+                };
+            } else {
+                auto value = std::make_shared<First>(f());
+                return [continuation, promise, value]() mutable {
+                    try {
+                        if constexpr (std::is_void_v<Result>) {
+                            continuation(std::move(*value));
+                            promise->set_value();
+                        } else {
+                            promise->set_value(continuation(std::move(*value)));
+                        }
+                    } catch (...) {
+                        promise->set_exception(std::current_exception());
+                    }
+                };
+            }
+        };
+
+        try {
+            // Submitted from a worker, so the continuation lands on this worker's deque
+            submit(step());
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
+
+template <typename T>
+T Executor::await(std::future<T>& future) {
+    if (isWorkerThread()) {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!runPendingTask()) {
+                // Nothing to help with: the value depends on a blocked task, so wait briefly
+                BlockingScope blocking;
+                future.wait_for(std::chrono::microseconds(200));
+            }
+        }
+    }
+    return future.get();
+}
+
+#endif // EXECUTOR_H
@@ -0,0 +1,259 @@
+// graph.cpp
+#include "graph.h"
+#include <iostream>
+#include <map>
+#include <set>
+
+namespace {
+
+// Name of the run-context entry holding the graph input
+const std::string GRAPH_INPUT_KEY = "input";
+
+bool isPointer(const nlohmann::json& value) {
+    return value.is_string() && !value.get_ref<const std::string&>().empty() && value.get_ref<const std::string&>()[0] == '/';
+}
+
+} // namespace
+
+// Parses a graph definition and computes its topological order
+bool Graph::load(const nlohmann::json& config) {
+    m_steps.clear();
+    m_order.clear();
+    m_outputs.clear();
+
+    std::map<std::string, size_t> indexById;
+    try {
+        m_id = config.at("id").get<std::string>();
+        m_version = std::hash<nlohmann::json>{}(config);
+
+        // 1. Steps
+        for (const auto& node_json : config.at("nodes")) {
+            GraphStep step;
+            step.id = node_json.at("id").get<std::string>();
+            step.nodeId = node_json.at("node").get<std::string>();
+            if (node_json.contains("input")) {
+                step.inputMapping = node_json["input"];
+            }
+            if (step.id == GRAPH_INPUT_KEY) {
+                std::cerr << "Graph Error: '" << m_id << "' uses the reserved step ID '" << GRAPH_INPUT_KEY << "'." << std::endl;
+                return false;
+            }
+            if (indexById.count(step.id)) {
+                std::cerr << "Graph Error: '" << m_id << "' defines step '" << step.id << "' twice." << std::endl;
+                return false;
+            }
+            indexById[step.id] = m_steps.size();
+            m_steps.push_back(std::move(step));
+        }
+
+        // 2. Edges: explicit ones plus those implied by input mappings
+        std::vector<std::pair<std::string, std::string>> edges;
+        if (config.contains("edges")) {
+            for (const auto& edge_json : config["edges"]) {
+                edges.emplace_back(edge_json.at("from").get<std::string>(), edge_json.at("to").get<std::string>());
+                if (edge_json.contains("stream")) {
+                    ChunkGranularity granularity;
+                    if (!parseChunkGranularity(edge_json["stream"].get<std::string>(), granularity)) {
+                        std::cerr << "Graph Error: '" << m_id << "' edge '" << edges.back().first << "' -> '" << edges.back().second
+                                  << "' has an unknown 'stream' granularity." << std::endl;
+                        return false;
+                    }
+                    auto target = indexById.find(edges.back().second);
+                    if (target != indexById.end()) {
+                        m_steps[target->second].inputGranularity = granularity;
+                    }
+                }
+            }
+        }
+        for (const GraphStep& step : m_steps) {
+            std::vector<std::string> references;
+            collectReferences(step.inputMapping, references);
+            for (const std::string& reference : references) {
+                if (reference != GRAPH_INPUT_KEY) {
+                    edges.emplace_back(reference, step.id);
+                }
+            }
+        }
+
+        // Parts of the graph input each step reads (for incremental sessions)
+        for (GraphStep& step : m_steps) {
+            collectInputPaths(step.inputMapping, step.inputPaths);
+        }
+
+        std::set<std::pair<size_t, size_t>> seenEdges;
+        for (const auto& [from, to] : edges) {
+            if (!indexById.count(from) || !indexById.count(to)) {
+                std::cerr << "Graph Error: '" << m_id << "' has an edge '" << from << "' -> '" << to << "' to an unknown step." << std::endl;
+                return false;
+            }
+            size_t fromIndex = indexById[from];
+            size_t toIndex = indexById[to];
+            if (!seenEdges.insert({fromIndex, toIndex}).second) {
+                continue; // Same edge given explicitly and by a mapping
+            }
+            m_steps[toIndex].dependencies.push_back(fromIndex);
+            m_steps[fromIndex].dependents.push_back(toIndex);
+        }
+
+        // A streamed edge feeds its target chunk by chunk, so it must be the only one
+        for (const GraphStep& step : m_steps) {
+            if (step.inputGranularity != ChunkGranularity::Full && step.dependencies.size() != 1) {
+                std::cerr << "Graph Error: '" << m_id << "' step '" << step.id
+                          << "' takes a streamed edge but depends on more than one step." << std::endl;
+                return false;
+            }
+        }
+
+        // Without a mapping, a step with no dependencies gets the whole input
+        for (GraphStep& step : m_steps) {
+            if (step.inputMapping.is_null() && step.dependencies.empty()) {
+                step.inputPaths.push_back("");
+            }
+        }
+
+        // 3. Outputs: "output" (one step) or "outputs" (several); default is every sink step
+        if (config.contains("output")) {
+            std::string output = config["output"].get<std::string>();
+            if (!indexById.count(output)) {
+                std::cerr << "Graph Error: '" << m_id << "' output '" << output << "' is not a step." << std::endl;
+                return false;
+            }
+            m_outputs.push_back(indexById[output]);
+        } else if (config.contains("outputs")) {
+            for (const auto& output_json : config["outputs"]) {
+                std::string output = output_json.get<std::string>();
+                if (!indexById.count(output)) {
+                    std::cerr << "Graph Error: '" << m_id << "' output '" << output << "' is not a step." << std::endl;
+                    return false;
+                }
+                m_outputs.push_back(indexById[output]);
+            }
+        } else {
+            for (size_t i = 0; i < m_steps.size(); ++i) {
+                if (m_steps[i].dependents.empty()) {
+                    m_outputs.push_back(i);
+                }
+            }
+        }
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "Graph Error: Missing or invalid field in graph definition: " << e.what() << std::endl;
+        return false;
+    }
+
+    // 4. Topological order (Kahn's algorithm); leftover steps mean there is a cycle
+    std::vector<size_t> remaining(m_steps.size());
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < m_steps.size(); ++i) {
+        remaining[i] = m_steps[i].dependencies.size();
+        if (remaining[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    while (!ready.empty()) {
+        size_t index = ready.back();
+        ready.pop_back();
+        m_order.push_back(index);
+        for (size_t dependent : m_steps[index].dependents) {
+            if (--remaining[dependent] == 0) {
+                ready.push_back(dependent);
+            }
+        }
+    }
+    if (m_order.size() != m_steps.size()) {
+        std::cerr << "Graph Error: '" << m_id << "' contains a cycle." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Graph::bindNodes(const std::function<NodeRef(const std::string&)>& resolve) {
+    for (GraphStep& step : m_steps) {
+        step.node = resolve(step.nodeId);
+    }
+}
+
+nlohmann::json Graph::buildInput(size_t stepIndex, const nlohmann::json& context) const {
+    const GraphStep& step = m_steps[stepIndex];
+    if (!step.inputMapping.is_null()) {
+        return resolveMapping(step.inputMapping, context);
+    }
+
+    if (step.dependencies.empty()) {
+        return context.value(GRAPH_INPUT_KEY, nlohmann::json());
+    }
+    if (step.dependencies.size() == 1) {
+        return context.value(m_steps[step.dependencies.front()].id, nlohmann::json());
+    }
+    nlohmann::json combined = nlohmann::json::object();
+    for (size_t dependency : step.dependencies) {
+        const std::string& id = m_steps[dependency].id;
+        combined[id] = context.value(id, nlohmann::json());
+    }
+    return combined;
+}
+
+bool Graph::readsInput(size_t stepIndex, const std::string& path) const {
+    // Related if one pointer is a prefix of the other at a token boundary
+    auto covers = [](const std::string& outer, const std::string& inner) {
+        return inner.compare(0, outer.size(), outer) == 0 && (inner.size() == outer.size() || inner[outer.size()] == '/');
+    };
+    for (const std::string& read : m_steps[stepIndex].inputPaths) {
+        if (covers(read, path) || covers(path, read)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+nlohmann::json Graph::resolveMapping(const nlohmann::json& mapping, const nlohmann::json& context) {
+    if (isPointer(mapping)) {
+        nlohmann::json::json_pointer pointer(mapping.get<std::string>());
+        if (!context.contains(pointer)) {
+            std::cerr << "Graph Warning: Input mapping '" << mapping.get<std::string>() << "' does not resolve; using null." << std::endl;
+            return nlohmann::json();
+        }
+        return context.at(pointer);
+    }
+    if (mapping.is_object()) {
+        nlohmann::json resolved = nlohmann::json::object();
+        for (const auto& [key, value] : mapping.items()) {
+            resolved[key] = resolveMapping(value, context);
+        }
+        return resolved;
+    }
+    if (mapping.is_array()) {
+        nlohmann::json resolved = nlohmann::json::array();
+        for (const auto& value : mapping) {
+            resolved.push_back(resolveMapping(value, context));
+        }
+        return resolved;
+    }
+    return mapping; // Literal
+}
+
+void Graph::collectReferences(const nlohmann::json& mapping, std::vector<std::string>& references) {
+    if (isPointer(mapping)) {
+        const std::string& pointer = mapping.get_ref<const std::string&>();
+        static_cast<void>(nlohmann::json::json_pointer(pointer)); // Throws on malformed pointers while loading
+        size_t end = pointer.find('/', 1);
+        references.push_back(pointer.substr(1, end == std::string::npos ? std::string::npos : end - 1));
+    } else if (mapping.is_structured()) {
+        for (const auto& value : mapping) {
+            collectReferences(value, references);
+        }
+    }
+}
+
+void Graph::collectInputPaths(const nlohmann::json& mapping, std::vector<std::string>& paths) {
+    if (isPointer(mapping)) {
+        const std::string& pointer = mapping.get_ref<const std::string&>();
+        const std::string prefix = "/" + GRAPH_INPUT_KEY;
+        if (pointer.compare(0, prefix.size(), prefix) == 0 && (pointer.size() == prefix.size() || pointer[prefix.size()] == '/')) {
+            paths.push_back(pointer.substr(prefix.size()));
+        }
+    } else if (mapping.is_structured()) {
+        for (const auto& value : mapping) {
+            collectInputPaths(value, paths);
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include "node_ref.h"
+#include "stream_chunker.h"
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// One step of a graph: runs a registered Node on an input assembled from the
+// graph input and the outputs of earlier steps.
+struct GraphStep {
+    std::string id;                  // Step name, unique within the graph
+    std::string nodeId;              // Linker Node that executes this step
+    NodeRef node;                    // nodeId resolved by bindNodes() (invalid if unknown)
+    nlohmann::json inputMapping;     // How to build the input (null = default, see Graph::buildInput)
+    std::vector<size_t> dependencies; // Indices of steps that must finish first
+    std::vector<size_t> dependents;   // Indices of steps waiting on this one
+    std::vector<std::string> inputPaths; // Parts of the graph input it reads, as JSON pointers into the input ("" = all)
+    // How its dependency's output reaches it: Full waits for the whole output;
+    // a finer granularity (a streamed edge) runs the step on each chunk of it
+    ChunkGranularity inputGranularity = ChunkGranularity::Full;
+};
+
+// A Graph is a DAG of steps loaded from a JSON definition in the graphs/ directory:
+//
+// {
+//   "id": "mia_conversation",
+//   "nodes": [
+//     {"id": "optimize", "node": "general_assistant", "input": {"content": "/input/content"}},
+//     {"id": "respond",  "node": "new_assistant",     "input": {"content": "/optimize/generated_text"}}
+//   ],
+//   "edges": [{"from": "optimize", "to": "respond"}],
+//   "output": "respond"
+// }
+//
+// Input mappings are JSON pointers into the run context, an object holding the
+// graph input under "input" and every finished step's output under its step ID.
+// A pointer to another step's output implies an edge from that step, so
+// "edges" only needs to list ordering constraints that carry no data.
+//
+// An edge may stream: {"from": "draft", "to": "translate", "stream": "sentence"}
+// ("token", "sentence", "paragraph" or "full", the default). The target then
+// runs once per chunk of the source's text while the source is still
+// generating it, seeing the chunk as the source's {"generated_text"}, and its
+// outputs are concatenated (see Linker::runGraph()). The target of a streamed
+// edge must have no other dependency. Use "full" wherever the target has to
+// see the whole text at once, e.g. to answer a prompt.
+class Graph {
+public:
+    // Parses and validates a definition (unique step IDs, known edge endpoints,
+    // no cycles). Returns false and logs the problem if it is invalid.
+    bool load(const nlohmann::json& config);
+
+    // Resolves every step's nodeId to a NodeRef once, so runs route by handle.
+    void bindNodes(const std::function<NodeRef(const std::string&)>& resolve);
+
+    const std::string& getId() const { return m_id; }
+    // Hash of the definition: changes with any edit to it
+    uint64_t getVersion() const { return m_version; }
+    const std::vector<GraphStep>& getSteps() const { return m_steps; }
+    // Step indices in a valid topological order.
+    const std::vector<size_t>& getTopologicalOrder() const { return m_order; }
+    // Indices of the steps whose outputs form the graph result.
+    const std::vector<size_t>& getOutputs() const { return m_outputs; }
+
+    // Builds the input of a step from the run context:
+    // - with an input mapping, each string value starting with '/' is replaced by
+    //   the value it points to (other values are copied as literals), and a
+    //   mapping that is itself a pointer string selects that value directly;
+    // - without one, a step with no dependencies gets the graph input, a step
+    //   with one dependency gets that step's output, and a step with several gets
+    //   an object of their outputs keyed by step ID.
+    nlohmann::json buildInput(size_t stepIndex, const nlohmann::json& context) const;
+
+    // True if a change at path (a JSON pointer into the graph input, e.g. from
+    // nlohmann::json::diff) can change the step's input directly.
+    bool readsInput(size_t stepIndex, const std::string& path) const;
+
+private:
+    // Resolves mapping values against the context (recursively for objects/arrays)
+    static nlohmann::json resolveMapping(const nlohmann::json& mapping, const nlohmann::json& context);
+    // Collects the step names referenced by pointer strings inside a mapping
+    static void collectReferences(const nlohmann::json& mapping, std::vector<std::string>& references);
+    // Collects the graph-input pointers of a mapping, relative to the input
+    static void collectInputPaths(const nlohmann::json& mapping, std::vector<std::string>& paths);
+
+    std::string m_id;
+    uint64_t m_version = 0;
+    std::vector<GraphStep> m_steps;
+    std::vector<size_t> m_order;
+    std::vector<size_t> m_outputs;
+};
+
+#endif // GRAPH_H
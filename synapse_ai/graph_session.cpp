@@ -0,0 +1,106 @@
+// graph_session.cpp
+#include "graph_session.h"
+#include "linker.h"
+#include <iostream>
+
+GraphSession::GraphSession(const Graph& graph)
+    : m_graph(graph),
+      m_context(nlohmann::json::object()),
+      m_valid(graph.getSteps().size(), false),
+      m_lastInputs(graph.getSteps().size()),
+      m_results(graph.getSteps().size()) {
+}
+
+const nlohmann::json& GraphSession::input() const {
+    static const nlohmann::json empty;
+    auto it = m_context.find("input");
+    return it != m_context.end() ? *it : empty;
+}
+
+GraphResult GraphSession::update(nlohmann::json input) {
+    const std::vector<GraphStep>& steps = m_graph.getSteps();
+
+    // 1. Steps that read a part of the input that changed
+    std::vector<bool> dirty(steps.size(), false);
+    if (m_context.contains("input")) {
+        for (const auto& operation : nlohmann::json::diff(m_context["input"], input)) {
+            const std::string& path = operation["path"].get_ref<const std::string&>();
+            for (size_t i = 0; i < steps.size(); ++i) {
+                if (!dirty[i] && m_graph.readsInput(i, path)) {
+                    dirty[i] = true;
+                }
+            }
+        }
+    }
+    m_context["input"] = std::move(input);
+
+    // 2. Run, deciding for every step when it is ready. A step is affected if
+    // it is dirty, has no valid result, or a dependency ran again in this update;
+    // an affected step whose input came out unchanged is still reused.
+    std::vector<bool> executed(steps.size(), false);
+    std::vector<nlohmann::json> newInputs(steps.size());
+    auto reuse = [&](size_t index, nlohmann::json& stepInput, NodeResult& reused) {
+        bool affected = !m_valid[index] || dirty[index];
+        for (size_t dependency : steps[index].dependencies) {
+            affected = affected || executed[dependency];
+        }
+        if (affected) {
+            stepInput = m_graph.buildInput(index, m_context);
+            if (!m_valid[index] || stepInput != m_lastInputs[index]) {
+                executed[index] = true;
+                newInputs[index] = stepInput;
+                return false;
+            }
+        }
+        reused = m_results[index];
+        return true;
+    };
+    GraphResult result = Linker::getInstance().runGraphSteps(m_graph, m_context, reuse);
+
+    // 3. Keep what the next update may reuse
+    for (size_t i = 0; i < steps.size(); ++i) {
+        if (!executed[i] && m_valid[i] && result.steps.count(steps[i].id)) {
+            continue; // Reused
+        }
+        auto it = result.steps.find(steps[i].id);
+        if (executed[i] && it != result.steps.end() && it->second.success) {
+            m_valid[i] = true;
+            m_results[i] = it->second;
+            m_lastInputs[i] = std::move(newInputs[i]);
+        } else {
+            // Failed or skipped: nothing valid to reuse
+            m_valid[i] = false;
+            m_results[i] = NodeResult();
+            m_lastInputs[i] = nlohmann::json();
+            m_context.erase(steps[i].id);
+        }
+    }
+    std::cout << "GraphSession: Graph '" << m_graph.getId() << "' updated; " << result.reused.size() << " of "
+              << steps.size() << " steps reused." << std::endl;
+    return result;
+}
+
+GraphResult GraphSession::set(const std::string& pointer, nlohmann::json value) {
+    nlohmann::json input = this->input();
+    try {
+        input[nlohmann::json::json_pointer(pointer)] = std::move(value);
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "GraphSession Error: Cannot set '" << pointer << "' in the input: " << e.what() << std::endl;
+        GraphResult failed;
+        failed.output = {{"success", false}, {"error_message", e.what()}};
+        return failed;
+    }
+    return update(std::move(input));
+}
+
+bool GraphSession::invalidate(const std::string& stepId) {
+    const std::vector<GraphStep>& steps = m_graph.getSteps();
+    for (size_t i = 0; i < steps.size(); ++i) {
+        if (steps[i].id == stepId) {
+            m_valid[i] = false;
+            return true;
+        }
+    }
+    std::cerr << "GraphSession Error: Graph '" << m_graph.getId() << "' has no step '" << stepId << "'." << std::endl;
+    return false;
+}
@@ -0,0 +1,49 @@
+#ifndef GRAPH_SESSION_H
+#define GRAPH_SESSION_H
+
+#include "graph.h"
+#include "node.h"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+struct GraphResult;
+
+// A GraphSession keeps the results of a graph between runs, so that an
+// iterative session (edit one field, look at the result, edit again) re-executes
+// only what the edit affects:
+// - update() diffs the new input against the previous one. Steps that read a
+//   changed part of the input are dirty; so is everything downstream of them.
+// - A dirty step whose freshly built input equals its previous input is
+//   reused after all (early cutoff): a re-run upstream step that produced the
+//   same output does not ripple further.
+// - Clean steps keep their previous result without building an input.
+// - Failed or skipped steps always run again on the next update.
+// Independent dirty branches still run concurrently. Obtain sessions from
+// Linker::openGraphSession(); one session is used by one thread at a time.
+class GraphSession {
+public:
+    explicit GraphSession(const Graph& graph);
+
+    // Runs the graph on input, reusing whatever the change leaves valid.
+    // The first update runs every step.
+    GraphResult update(nlohmann::json input);
+    // Replaces one value of the current input (pointer is a JSON pointer into
+    // the input, e.g. "/content") and updates.
+    GraphResult set(const std::string& pointer, nlohmann::json value);
+    // Makes a step (and so its downstream) run again at the next update, e.g.
+    // after its node's configuration changed.
+    bool invalidate(const std::string& stepId);
+
+    const nlohmann::json& input() const;
+    const std::string& getGraphId() const { return m_graph.getId(); }
+
+private:
+    const Graph& m_graph;
+    nlohmann::json m_context;                 // "input" plus the outputs of valid steps
+    std::vector<bool> m_valid;                // Step has a successful result
+    std::vector<nlohmann::json> m_lastInputs; // Input each valid step ran on
+    std::vector<NodeResult> m_results;        // Last result of each valid step
+};
+
+#endif // GRAPH_SESSION_H
@@ -0,0 +1,117 @@
+// join_node.cpp
+#include "join_node.h"
+#include "linker.h"
+#include <iostream>
+
+bool parseJoinMode(const std::string& name, JoinMode& mode) {
+    if (name == "all") {
+        mode = JoinMode::All;
+    } else if (name == "first_k") {
+        mode = JoinMode::FirstK;
+    } else if (name == "quorum") {
+        mode = JoinMode::Quorum;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+JoinMerge joinMergeByName(const std::string& name) {
+    if (name == "collect") {
+        return [](const std::vector<JoinBranch>& branches) {
+            nlohmann::json results = nlohmann::json::object();
+            for (const JoinBranch& branch : branches) {
+                results[branch.nodeId] = branch.result.output;
+            }
+            return nlohmann::json{{"results", std::move(results)}};
+        };
+    }
+    if (name == "concat") {
+        return [](const std::vector<JoinBranch>& branches) {
+            std::string text;
+            for (const JoinBranch& branch : branches) {
+                const nlohmann::json& output = branch.result.output;
+                if (output.contains("generated_text") && output["generated_text"].is_string()) {
+                    if (!text.empty()) {
+                        text += "\n\n";
+                    }
+                    text += output["generated_text"].get<std::string>();
+                }
+            }
+            return nlohmann::json{{"generated_text", std::move(text)}};
+        };
+    }
+    if (name == "first") {
+        return [](const std::vector<JoinBranch>& branches) {
+            return branches.empty() ? nlohmann::json::object() : branches.front().result.output;
+        };
+    }
+    return nullptr;
+}
+
+JoinMerge defaultJoinMerge(const JoinPolicy& policy) {
+    if (policy.mode == JoinMode::Quorum || (policy.mode == JoinMode::FirstK && policy.k <= 1)) {
+        return joinMergeByName("first");
+    }
+    return joinMergeByName("collect");
+}
+
+JoinNode::JoinNode(const std::string& id, std::vector<std::string> branches, JoinPolicy policy, JoinMerge merge)
+    : m_branches(std::move(branches)), m_policy(std::move(policy)), m_merge(std::move(merge)) {
+    m_id = id;
+}
+
+std::unique_ptr<JoinNode> JoinNode::fromJson(const nlohmann::json& config) {
+    try {
+        std::string id = config.at("id").get<std::string>();
+        std::vector<std::string> branches = config.at("branches").get<std::vector<std::string>>();
+        if (branches.empty()) {
+            std::cerr << "JoinNode Error: Join '" << id << "' has no branches." << std::endl;
+            return nullptr;
+        }
+
+        JoinPolicy policy;
+        std::string mode = config.value("policy", "all");
+        if (!parseJoinMode(mode, policy.mode)) {
+            std::cerr << "JoinNode Error: Unknown join policy '" << mode << "' in join '" << id << "'." << std::endl;
+            return nullptr;
+        }
+        policy.k = config.value("k", policy.k);
+        policy.cancelStragglers = config.value("cancel_stragglers", policy.cancelStragglers);
+        policy.voteField = config.value("vote_field", policy.voteField);
+        if (config.contains("accept") && !Predicate::compile(config["accept"], policy.accept)) {
+            std::cerr << "JoinNode Error: Invalid 'accept' predicate in join '" << id << "'." << std::endl;
+            return nullptr;
+        }
+        if (policy.k > branches.size()) {
+            std::cerr << "JoinNode Error: Join '" << id << "' needs k <= " << branches.size() << "." << std::endl;
+            return nullptr;
+        }
+
+        JoinMerge merge = defaultJoinMerge(policy);
+        if (config.contains("merge")) {
+            std::string mergeName = config["merge"].get<std::string>();
+            merge = joinMergeByName(mergeName);
+            if (!merge) {
+                std::cerr << "JoinNode Error: Unknown merge '" << mergeName << "' in join '" << id << "'." << std::endl;
+                return nullptr;
+            }
+        }
+        return std::make_unique<JoinNode>(id, std::move(branches), std::move(policy), std::move(merge));
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "JoinNode Error: Invalid join definition: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+bool JoinNode::push(nlohmann::json data) {
+    return pushMessage(Message(std::move(data)));
+}
+
+bool JoinNode::pushMessage(Message message) {
+    // The branches share the payload; the message's token reaches them, so a
+    // cancelled caller also cancels this join
+    JoinResult result = Linker::getInstance().sendMessageJoin(m_branches, std::move(message), m_policy, m_merge);
+    m_data_out = std::move(result.output);
+    return result.success;
+}
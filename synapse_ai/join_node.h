@@ -0,0 +1,96 @@
+#ifndef JOIN_NODE_H
+#define JOIN_NODE_H
+
+#include "node.h"
+#include "predicate.h"
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// When a fan-in join (Linker::sendDataJoin) is complete.
+enum class JoinMode {
+    All,    // Wait for every branch; succeeds if all of them succeeded
+    FirstK, // Done as soon as k branches succeeded; the others are cancelled
+    Quorum  // Done as soon as k successful branches agree (0 = majority); the others are cancelled
+};
+
+// Parses "all" / "first_k" / "quorum". Returns false for anything else.
+bool parseJoinMode(const std::string& name, JoinMode& mode);
+
+struct JoinPolicy {
+    JoinMode mode = JoinMode::All;
+    size_t k = 0;                // FirstK: successes needed (0 = 1). Quorum: agreeing votes needed (0 = majority)
+    bool cancelStragglers = true; // Abort branches whose result is no longer needed
+    // Quorum: the output field a branch votes with. Votes are compared after
+    // trimming whitespace and lower-casing, so "Yes." and "yes." agree.
+    std::string voteField = "generated_text";
+    // A successful branch whose output fails this test counts as failed
+    // (e.g. an empty or refused answer). Accepts everything by default.
+    Predicate accept;
+};
+
+// A finished branch: the node it ran on and its result.
+struct JoinBranch {
+    std::string nodeId;
+    NodeResult result;
+};
+
+// Assembles the join output from the branches that decided it (All: every
+// successful branch; FirstK: the first k successes; Quorum: the agreeing
+// branches), in completion order.
+using JoinMerge = std::function<nlohmann::json(const std::vector<JoinBranch>& branches)>;
+
+// Built-in merges, selected by name in a join node's JSON ("merge"):
+// - "collect": {"results": {nodeId: output, ...}}
+// - "concat":  {"generated_text": the branches' texts, separated by blank lines}
+// - "first":   the first branch's output unchanged (also the Quorum winner's text)
+// Returns nullptr for an unknown name.
+JoinMerge joinMergeByName(const std::string& name);
+// The merge a policy uses when none is given: "first" for FirstK with k <= 1
+// and for Quorum, "collect" otherwise.
+JoinMerge defaultJoinMerge(const JoinPolicy& policy);
+
+// Outcome of a join.
+struct JoinResult {
+    bool success = false;
+    nlohmann::json output;              // Merged output, with "success" (and "error_message" on failure)
+    std::vector<JoinBranch> branches;   // Every branch that finished before the join was decided
+    std::vector<std::string> cancelled; // Branches still running (or not started) when it was decided
+};
+
+// A JoinNode fans its input out to a fixed set of branch nodes and joins their
+// results with a policy, so a join can sit anywhere a node can (graphs, streams,
+// actors). Configured from a JSON file in the agents/ directory:
+//
+// {
+//   "id": "consensus",
+//   "type": "join",
+//   "branches": ["general_assistant", "new_assistant"],
+//   "policy": "quorum",          // "all" | "first_k" | "quorum"
+//   "k": 0,                      // first_k: successes (0 = 1); quorum: votes (0 = majority)
+//   "merge": "first",            // "collect" | "concat" | "first" (optional)
+//   "cancel_stragglers": true,   // optional
+//   "vote_field": "generated_text", // optional
+//   "accept": {"min_length": 1}     // optional Predicate (see predicate.h)
+// }
+class JoinNode : public Node {
+public:
+    JoinNode(const std::string& id, std::vector<std::string> branches, JoinPolicy policy, JoinMerge merge);
+
+    // Builds a JoinNode from its JSON definition. Returns nullptr (and logs) if it is invalid.
+    static std::unique_ptr<JoinNode> fromJson(const nlohmann::json& config);
+
+    const std::string& getId() const override { return m_id; }
+    bool push(nlohmann::json data) override;
+    bool pushMessage(Message message) override;
+    const nlohmann::json& pull() override { return m_data_out; }
+
+private:
+    std::vector<std::string> m_branches;
+    JoinPolicy m_policy;
+    JoinMerge m_merge;
+};
+
+#endif // JOIN_NODE_H
@@ -2,12 +2,206 @@
 #include "api_communicator.h"
 #include "agent.h" // Include Agent header to create Agent objects
 #include "api_communicator_node.h" // Include the new wrapper node header
+#include "race_node.h"
+#include "router_node.h"
+#include "worker_host.h"
 #include <iostream> // For logging and error messages
 #include <fstream>  // For file input
 #include <filesystem> // For directory traversal (C++17)
+#include "executor.h" // Work-stealing pool that runs node executions
+#include "bounded_queue.h" // Queues between pipeline stages
+#include <thread>
+#include <atomic>
+#include <set>
+#include <condition_variable>
+#include <functional>
+#include <cctype>
 
 // Define the directory where agent JSON configurations are stored
 const std::string AGENT_CONFIG_DIR = "agents";
+// Define the directory where graph JSON definitions are stored
+const std::string GRAPH_CONFIG_DIR = "graphs";
+
+namespace {
+
+// Result reported for a send to a Node ID that is not registered
+NodeResult unknownNodeResult(const std::string& nodeId) {
+    std::cerr << "Linker Error: Destination Node ID '" << nodeId << "' not found." << std::endl;
+    NodeResult result;
+    result.output = {{"success", false}, {"error_message", "Node '" + nodeId + "' not found."}};
+    return result;
+}
+
+// State shared by a join's branch tasks and its caller. Branches that are still
+// running when the join is decided keep it alive after the caller returns.
+struct JoinState {
+    std::mutex mutex;
+    bool decided = false;
+    bool success = false;
+    std::vector<bool> done;                        // Per target: branch finished
+    std::vector<JoinBranch> finished;              // Completion order, until decided
+    std::vector<JoinBranch> winners;               // Branches that decided the join
+    std::map<std::string, std::vector<size_t>> votes; // Quorum: vote -> indices into finished
+    size_t succeeded = 0;
+    size_t failed = 0;
+    std::promise<void> decision;
+};
+
+// The value a branch votes with: the vote field, trimmed and lower-cased
+std::string voteKey(const nlohmann::json& output, const std::string& field) {
+    if (!output.contains(field)) {
+        return std::string();
+    }
+    std::string vote = output[field].is_string() ? output[field].get<std::string>() : output[field].dump();
+    size_t begin = vote.find_first_not_of(" \t\r\n");
+    size_t end = vote.find_last_not_of(" \t\r\n");
+    vote = begin == std::string::npos ? std::string() : vote.substr(begin, end - begin + 1);
+    for (char& c : vote) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return vote;
+}
+
+// Checks whether the branch just added to state.finished decides the join.
+// Sets success and winners when it does. state.mutex must be held.
+bool decideJoin(JoinState& state, const JoinPolicy& policy, size_t needed, size_t total) {
+    const size_t latest = state.finished.size() - 1;
+    const JoinBranch& branch = state.finished[latest];
+    auto successes = [&state] {
+        std::vector<JoinBranch> result;
+        for (const JoinBranch& b : state.finished) {
+            if (b.result.success) {
+                result.push_back(b);
+            }
+        }
+        return result;
+    };
+
+    switch (policy.mode) {
+    case JoinMode::All:
+        if (state.finished.size() < total) {
+            return false;
+        }
+        state.success = state.failed == 0;
+        state.winners = successes();
+        return true;
+    case JoinMode::FirstK:
+        if (state.succeeded >= needed) {
+            state.success = true;
+        } else if (state.failed > total - needed) {
+            state.success = false; // Too few branches left to reach k
+        } else {
+            return false;
+        }
+        state.winners = successes();
+        return true;
+    case JoinMode::Quorum: {
+        if (branch.result.success) {
+            std::vector<size_t>& group = state.votes[voteKey(branch.result.output, policy.voteField)];
+            group.push_back(latest);
+            if (group.size() >= needed) {
+                state.success = true;
+                for (size_t index : group) {
+                    state.winners.push_back(state.finished[index]);
+                }
+                return true;
+            }
+        }
+        // Fail early once no vote can reach the quorum any more
+        size_t largest = 0;
+        const std::vector<size_t>* leader = nullptr;
+        for (const auto& [vote, group] : state.votes) {
+            if (group.size() > largest) {
+                largest = group.size();
+                leader = &group;
+            }
+        }
+        if (largest + (total - state.finished.size()) >= needed) {
+            return false;
+        }
+        state.success = false;
+        if (leader != nullptr) {
+            for (size_t index : *leader) {
+                state.winners.push_back(state.finished[index]);
+            }
+        }
+        return true;
+    }
+    }
+    return false;
+}
+
+// Threads of one pipelined stream and the queues between them. If the caller
+// unwinds before join() (e.g. a sink threw), the destructor cancels the stages'
+// requests, closes every queue so blocked stages wake up, and joins them, so no
+// joinable thread is ever destroyed.
+template <typename T>
+class PipelineThreads {
+public:
+    PipelineThreads(std::vector<std::unique_ptr<BoundedQueue<T>>>& queues, const CancellationToken& cancellation)
+        : m_queues(queues), m_cancellation(cancellation) {}
+
+    ~PipelineThreads() {
+        if (m_threads.empty()) {
+            return;
+        }
+        m_cancellation.cancel();
+        for (auto& queue : m_queues) {
+            queue->close();
+        }
+        join();
+    }
+
+    PipelineThreads(const PipelineThreads&) = delete;
+    PipelineThreads& operator=(const PipelineThreads&) = delete;
+
+    // The thread runs under the caller's schedule, like an executor task
+    template <typename F>
+    void spawn(F&& body) {
+        m_threads.emplace_back([schedule = Schedule::current(), body = std::forward<F>(body)]() mutable {
+            Schedule::Scope scheduleScope(schedule);
+            body();
+        });
+    }
+
+    void join() {
+        for (std::thread& thread : m_threads) {
+            thread.join();
+        }
+        m_threads.clear();
+    }
+
+private:
+    std::vector<std::unique_ptr<BoundedQueue<T>>>& m_queues;
+    CancellationToken m_cancellation;
+    std::vector<std::thread> m_threads;
+};
+
+// Chunks that may wait between two streaming stages before the upstream one blocks
+const size_t CHUNK_QUEUE_CAPACITY = 64;
+
+// Adds the result of one chunk to the result of a step fed over a streamed
+// edge: the texts are concatenated, and the first failure replaces the whole.
+void foldChunkResult(std::map<size_t, NodeResult>& results, size_t index, NodeResult part) {
+    auto it = results.find(index);
+    if (it == results.end()) {
+        results.emplace(index, std::move(part));
+        return;
+    }
+    NodeResult& whole = it->second;
+    if (!whole.success) {
+        return;
+    }
+    if (!part.success) {
+        whole = std::move(part);
+        return;
+    }
+    if (whole.output.is_object() && part.output.is_object()) {
+        whole.output["generated_text"] = whole.output.value("generated_text", "") + part.output.value("generated_text", "");
+    }
+}
+
+} // namespace
 
 // Static method to get the single instance of Linker (Singleton implementation)
 Linker& Linker::getInstance() {
@@ -16,15 +210,36 @@ Linker& Linker::getInstance() {
 }
 
 // Private constructor implementation
-Linker::Linker() {
-    // Any Linker-specific initialization can go here
+Linker::Linker()
+    : m_table(new NodeTable()) {
+    // Created first so that it is destroyed after the Linker: nodes retired
+    // during shutdown still have somewhere to go
+    EpochReclaimer::getInstance();
+}
+
+Linker::~Linker() {
+    if (m_checkpointer) {
+        captureCheckpoint();
+        m_checkpointer.reset(); // Writes what is queued, then stops the writer
+    }
+    delete m_table.load();
+}
+
+Linker::NodeSlot::~NodeSlot() {
+    delete node.load();
+    delete memo.load();
 }
 
 bool Linker::initialize() {
-    // 1. Get API Key from environment variable
+    // 1. Check that at least one API key source is configured
+    // (a single key, a comma-separated key pool, or a key file)
     const char* apiKeyCStr = std::getenv("GEMINI_API_KEY");
-    if (apiKeyCStr == nullptr || std::string(apiKeyCStr).empty()) {
+    const char* apiKeysCStr = std::getenv("GEMINI_API_KEYS");
+    const char* apiKeyFileCStr = std::getenv("GEMINI_API_KEY_FILE");
+    auto isSet = [](const char* value) { return value != nullptr && *value != '\0'; };
+    if (!isSet(apiKeyCStr) && !isSet(apiKeysCStr) && !isSet(apiKeyFileCStr)) {
         std::cerr << "Error: GEMINI_API_KEY environment variable not set or is empty." << std::endl;
+        std::cerr << "A key pool can also be given as GEMINI_API_KEYS=\"key1,key2\" or GEMINI_API_KEY_FILE=/path/to/keys (one key per line)." << std::endl;
         std::cerr << "Please set it (e.g., 'export GEMINI_API_KEY=\\\"YOUR_API_KEY\\\"' on Linux/macOS)" << std::endl;
         std::cerr << "       (e.g., 'set GEMINI_API_KEY=\\\"YOUR_API_KEY\\\"' on Windows Command Prompt)" << std::endl;
         std::cerr << "       (e.g., '$env:GEMINI_API_KEY=\\\"YOUR_API_KEY\\\"' on Windows PowerShell)" << std::endl;
@@ -47,6 +262,16 @@ bool Linker::initialize() {
     Linker::getInstance().registerNode("api_communicator", std::make_unique<ApiCommunicatorNode>("api_communicator"));
     std::cout << "Linker: ApiCommunicatorNode registered with ID 'api_communicator'." << std::endl;
 
+    // Admission control for actor-mode posts (0 = unlimited)
+    size_t maxInFlight = apiCommunicator.getBaseConfig().value("max_in_flight", static_cast<size_t>(0));
+    m_admission.configure(maxInFlight);
+    if (maxInFlight > 0) {
+        std::cout << "Linker: At most " << maxInFlight << " posted requests in flight." << std::endl;
+    }
+    // Starvation protection for lower priority classes (see Schedule)
+    Schedule::setAging(std::chrono::milliseconds(apiCommunicator.getBaseConfig().value(
+        "scheduler_aging_ms", static_cast<long long>(Schedule::aging().count()))));
+
 
     // 3. Load Agents from JSON configuration files
     std::cout << "Linker: Loading agents from directory: " << AGENT_CONFIG_DIR << std::endl;
@@ -76,6 +301,13 @@ bool Linker::initialize() {
                     continue;
                 }
 
+                // Definitions with a "type" other than "agent" are built-in node types
+                std::string type = agentConfig.value("type", "agent");
+                if (type != "agent") {
+                    loadTypedNode(type, agentConfig, filePath);
+                    continue;
+                }
+
                 // Extract agent properties
                 std::string id;
                 std::string name;
@@ -94,6 +326,7 @@ bool Linker::initialize() {
                     params.instructions = param_json.at("instructions").get<std::string>();
                     // maxHistoryTurns is not in your general_assistant.json, so provide a default or handle its absence
                     params.maxHistoryTurns = param_json.value("max_history_turns", 5); // Default to 5 if not present
+                    params.backend = param_json.value("backend", ""); // Empty selects the default backend
 
                 } catch (const nlohmann::json::exception& e) {
                     std::cerr << "Linker Error: Missing or invalid field in agent config " << filePath << ": " << e.what() << std::endl;
@@ -104,6 +337,7 @@ bool Linker::initialize() {
                 // std::make_unique creates a unique_ptr and constructs the Agent within it
                 auto agent = std::make_unique<Agent>(id, name, params);
                 Linker::getInstance().registerNode(id, std::move(agent)); // Transfer ownership
+                applyNodeOptions(id, agentConfig, filePath);
 
             }
         }
@@ -112,40 +346,500 @@ bool Linker::initialize() {
         return false;
     }
 
+    // 4. Load graph definitions (after the agents, so node references can be checked)
+    if (!loadGraphs()) {
+        return false;
+    }
+
+    // 5. Restore the last checkpoint (after every node exists). Workers leave
+    // checkpoints to the parent, which owns the file.
+    const nlohmann::json& baseConfig = apiCommunicator.getBaseConfig();
+    CheckpointConfig checkpointConfig;
+    if (baseConfig.contains("checkpoint") && !WorkerHost::active() &&
+        CheckpointConfig::fromJson(baseConfig["checkpoint"], checkpointConfig) && checkpointConfig.enabled) {
+        auto checkpointer = std::make_unique<Checkpointer>(checkpointConfig);
+        bool restored = checkpointer->restore([this](const std::string& nodeId, const nlohmann::json& state) {
+            EpochReclaimer::ReadScope scope;
+            Node* node = getNode(nodeId);
+            if (node == nullptr) {
+                return; // Node no longer defined
+            }
+            if (!node->loadState(state)) {
+                std::cerr << "Linker Warning: Checkpointed state of Node '" << nodeId << "' does not fit; ignored." << std::endl;
+            }
+        });
+        if (restored) {
+            m_checkpointer = std::move(checkpointer);
+            m_checkpointer->start([this] { captureCheckpoint(); });
+        } else {
+            std::cerr << "Linker Error: Checkpoints disabled; " << checkpointConfig.path << " is unusable." << std::endl;
+        }
+    }
+
     return true; // Indicate success
 }
 
+// Loads graph definitions from GRAPH_CONFIG_DIR. The directory is optional.
+bool Linker::loadGraphs() {
+    namespace fs = std::filesystem;
+    try {
+        if (!fs::exists(GRAPH_CONFIG_DIR) || !fs::is_directory(GRAPH_CONFIG_DIR)) {
+            std::cout << "Linker: No graph directory '" << GRAPH_CONFIG_DIR << "'; no graphs loaded." << std::endl;
+            return true;
+        }
+
+        std::cout << "Linker: Loading graphs from directory: " << GRAPH_CONFIG_DIR << std::endl;
+        for (const auto& entry : fs::directory_iterator(GRAPH_CONFIG_DIR)) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".json") {
+                continue;
+            }
+            std::string filePath = entry.path().string();
+
+            std::ifstream file(filePath);
+            if (!file.is_open()) {
+                std::cerr << "Linker Error: Could not open file " << filePath << std::endl;
+                continue;
+            }
+
+            nlohmann::json graphConfig;
+            try {
+                file >> graphConfig;
+            } catch (const nlohmann::json::parse_error& e) {
+                std::cerr << "Linker Error: JSON parse error in " << filePath << ": " << e.what() << std::endl;
+                continue;
+            }
+
+            Graph graph;
+            if (!graph.load(graphConfig)) {
+                std::cerr << "Linker Error: Invalid graph definition in " << filePath << std::endl;
+                continue;
+            }
+            graph.bindNodes([this](const std::string& nodeId) { return resolve(nodeId); });
+            for (const GraphStep& step : graph.getSteps()) {
+                if (!step.node.valid()) {
+                    std::cerr << "Linker Warning: Graph '" << graph.getId() << "' step '" << step.id
+                              << "' uses unknown Node '" << step.nodeId << "'." << std::endl;
+                }
+            }
+            std::cout << "Linker: Graph '" << graph.getId() << "' loaded (" << graph.getSteps().size() << " steps)." << std::endl;
+            std::string graphId = graph.getId();
+            m_graphs[graphId] = std::move(graph);
+        }
+    } catch (const fs::filesystem_error& e) {
+        std::cerr << "Linker Error: Filesystem error while loading graphs: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Linker::loadTypedNode(const std::string& type, const nlohmann::json& config, const std::string& filePath) {
+    std::unique_ptr<Node> node;
+    if (type == "join") {
+        node = JoinNode::fromJson(config);
+    } else if (type == "race") {
+        node = RaceNode::fromJson(config);
+    } else if (type == "router") {
+        node = RouterNode::fromJson(config);
+    } else {
+        std::cerr << "Linker Error: Unknown node type '" << type << "' in " << filePath << std::endl;
+        return false;
+    }
+    if (node == nullptr) {
+        std::cerr << "Linker Error: Invalid " << type << " node definition in " << filePath << std::endl;
+        return false;
+    }
+    std::string id = node->getId();
+    registerNode(id, std::move(node));
+    return applyNodeOptions(id, config, filePath);
+}
+
+// Applies the sections every node definition may have: "queue", "worker" and "memoize"
+bool Linker::applyNodeOptions(const std::string& nodeId, const nlohmann::json& config, const std::string& filePath) {
+    bool valid = true;
+    // Any edit to the definition (model, instructions, ...) changes the version
+    const uint64_t configVersion = std::hash<nlohmann::json>{}(config);
+    if (NodeSlot* nodeSlot = slot(resolve(nodeId))) {
+        nodeSlot->configVersion.store(configVersion, std::memory_order_relaxed);
+    }
+
+    // Optional mailbox limits for actor mode
+    MailboxConfig mailbox;
+    if (config.contains("queue")) {
+        if (MailboxConfig::fromJson(config["queue"], mailbox)) {
+            configureMailbox(nodeId, mailbox);
+        } else {
+            std::cerr << "Linker Error: Invalid 'queue' section in " << filePath << "; mailbox left unbounded." << std::endl;
+            valid = false;
+        }
+    }
+
+    // Optional worker process for isolation
+    if (config.contains("worker")) {
+        WorkerConfig worker;
+        bool enabled = false;
+        if (!WorkerConfig::fromJson(config["worker"], worker, enabled)) {
+            std::cerr << "Linker Error: Invalid 'worker' section in " << filePath << "; the node runs in-process." << std::endl;
+            valid = false;
+        } else if (enabled) {
+            hostInWorker(nodeId, worker);
+        }
+    }
+
+    // Optional output memoization for deterministic nodes
+    if (config.contains("memoize")) {
+        MemoConfig memo;
+        bool enabled = false;
+        if (!MemoConfig::fromJson(config["memoize"], memo, enabled)) {
+            std::cerr << "Linker Error: Invalid 'memoize' section in " << filePath << "; memoization disabled." << std::endl;
+            valid = false;
+        } else if (enabled) {
+            configureMemo(nodeId, memo, configVersion);
+        }
+    }
+    return valid;
+}
+
 // Registers a Node with its ID. Takes ownership of the unique_ptr.
+// Writers take m_registryMutex and publish copies; readers never lock (see slot()).
 void Linker::registerNode(const std::string& nodeId, std::unique_ptr<Node> nodePtr) {
     if (nodePtr == nullptr) {
         std::cerr << "Linker Error: Attempted to register a nullptr for Node ID: " << nodeId << std::endl;
         return;
     }
-    if (m_registeredNodes.count(nodeId)) {
-        std::cerr << "Linker Warning: Node ID '" << nodeId << "' already registered. Overwriting." << std::endl;
+    EpochReclaimer& reclaimer = EpochReclaimer::getInstance();
+    std::lock_guard<std::mutex> registryLock(m_registryMutex);
+    const NodeTable* table = m_table.load(std::memory_order_acquire);
+    auto it = table->index.find(nodeId);
+    if (it != table->index.end()) {
+        // Keep the slot (and so every NodeRef to it); only the node is replaced.
+        // Calls already running finish on the old node, which is deleted after them.
+        std::cout << "Linker: Replacing Node '" << nodeId << "'." << std::endl;
+        NodeSlot& nodeSlot = *table->slots[it->second];
+        reclaimer.retire(nodeSlot.node.exchange(nodePtr.release(), std::memory_order_acq_rel));
+        // Outputs of the old node do not apply
+        reclaimer.retire(nodeSlot.memo.exchange(nullptr, std::memory_order_acq_rel));
+        setMemoizedOutput(nodeSlot, Message());
+        nodeSlot.configVersion.fetch_add(1, std::memory_order_relaxed); // Journaled graph runs do not apply either
+    } else {
+        NodeRef ref;
+        ref.index = static_cast<uint32_t>(table->slots.size());
+        auto nodeSlot = std::make_unique<NodeSlot>();
+        nodeSlot->id = nodeId;
+        nodeSlot->node.store(nodePtr.release(), std::memory_order_relaxed); // Transfer ownership
+        nodeSlot->lock = std::make_unique<std::recursive_mutex>();
+        nodeSlot->actor = std::make_unique<NodeActor>(ref, nodeId);
+
+        // Publish a table with the new slot; readers still on the old one finish first
+        auto next = std::make_unique<NodeTable>(*table);
+        next->slots.push_back(nodeSlot.get());
+        next->index.emplace(nodeId, ref.index);
+        m_slots.push_back(std::move(nodeSlot));
+        m_table.store(next.release(), std::memory_order_release);
+        reclaimer.retire(table);
     }
-    m_registeredNodes[nodeId] = std::move(nodePtr); // Transfer ownership
     std::cout << "Linker: Node '" << nodeId << "' registered." << std::endl;
 }
 
+NodeRef Linker::resolve(const std::string& nodeId) const {
+    EpochReclaimer::ReadScope scope;
+    const NodeTable* table = m_table.load(std::memory_order_acquire);
+    NodeRef ref;
+    auto it = table->index.find(nodeId);
+    if (it != table->index.end()) {
+        ref.index = it->second;
+    }
+    return ref;
+}
+
+// Slots are never freed, so the pointer outlives the scope; only the table is reclaimed
+Linker::NodeSlot* Linker::slot(NodeRef ref) const {
+    EpochReclaimer::ReadScope scope;
+    const NodeTable* table = m_table.load(std::memory_order_acquire);
+    return ref.index < table->slots.size() ? table->slots[ref.index] : nullptr;
+}
+
+Node* Linker::getNode(NodeRef ref) const {
+    NodeSlot* nodeSlot = slot(ref);
+    return nodeSlot ? nodeSlot->node.load(std::memory_order_acquire) : nullptr;
+}
+
+Node* Linker::getNode(const std::string& nodeId) const {
+    return getNode(resolve(nodeId));
+}
+
+const std::string& Linker::getNodeId(NodeRef ref) const {
+    static const std::string none;
+    NodeSlot* nodeSlot = slot(ref);
+    return nodeSlot ? nodeSlot->id : none;
+}
+
+// The lock belongs to the slot, so it also serializes a replacement node with
+// the old one. A node that needs the lock is read again once it is held, so a
+// call that waited for it goes to the current node; that node is called with
+// the lock held even if it would not need it.
+Node* Linker::lockNode(NodeSlot& nodeSlot, std::unique_lock<std::recursive_mutex>& lock, bool tryOnly) {
+    Node* node = nodeSlot.node.load(std::memory_order_acquire);
+    if (node->supportsConcurrentPush()) {
+        return node; // Calling it unlocked is safe even if it is replaced meanwhile
+    }
+    if (tryOnly) {
+        lock = std::unique_lock<std::recursive_mutex>(*nodeSlot.lock, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return nullptr;
+        }
+    } else {
+        lock = std::unique_lock<std::recursive_mutex>(*nodeSlot.lock);
+    }
+    return nodeSlot.node.load(std::memory_order_acquire);
+}
+
 // Sends data to a single target Node
 bool Linker::sendData(const std::string& toId, nlohmann::json data) {
-    auto it = m_registeredNodes.find(toId);
-    if (it == m_registeredNodes.end()) {
+    NodeRef to = resolve(toId);
+    if (!to.valid()) {
         std::cerr << "Linker Error: Destination Node ID '" << toId << "' not found." << std::endl;
         return false;
     }
+    return sendData(to, std::move(data));
+}
+
+bool Linker::sendData(NodeRef to, nlohmann::json data) {
+    NodeSlot* target = slot(to);
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Invalid destination NodeRef." << std::endl;
+        return false;
+    }
 
-    // Access the raw pointer from the unique_ptr to call push()
-    Node* targetNode = it->second.get();
-    std::cout << "Linker: Sending data to Node '" << toId << "'" << std::endl;
-    return targetNode->push(data);
+    EpochReclaimer::ReadScope scope;
+    std::cout << "Linker: Sending data to Node '" << target->id << "'" << std::endl;
+    return deliver(*target, std::move(data), nullptr);
+}
+
+bool Linker::sendMessage(NodeRef to, Message message) {
+    NodeSlot* target = slot(to);
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Invalid destination NodeRef." << std::endl;
+        return false;
+    }
+    if (message.expired()) {
+        std::cerr << "Linker Warning: Message for Node '" << target->id << "' is past its deadline; dropped." << std::endl;
+        return false;
+    }
+
+    EpochReclaimer::ReadScope scope;
+    std::cout << "Linker: Sending message to Node '" << target->id << "'" << std::endl;
+    return deliver(*target, std::move(message), nullptr);
+}
+
+bool Linker::deliver(NodeSlot& target, Message message, Message* output) {
+    MemoCache* memo = target.memo.load(std::memory_order_acquire);
+    uint64_t memoKey = 0;
+    if (memo != nullptr) {
+        // A hit needs neither the node nor its lock
+        memoKey = memo->keyOf(message.data());
+        if (MemoCache::Output cached = memo->lookup(memoKey, message.data())) {
+            std::cout << "Linker: Reusing memoized output of Node '" << target.id << "'" << std::endl;
+            Message served = message.derive(target.id, std::move(cached));
+            if (output != nullptr) {
+                *output = served;
+            }
+            setMemoizedOutput(target, std::move(served));
+            return true;
+        }
+    }
+    // Kept (shared, not copied) as the cache entry's input
+    MemoCache::Input input = memo != nullptr ? message.payload() : nullptr;
+
+    std::unique_lock<std::recursive_mutex> lock;
+    Node* node = lockNode(target, lock);
+    setMemoizedOutput(target, Message()); // The node's own output is current again
+    bool pushed = node->pushMessage(std::move(message));
+    ++target.version;
+    const bool memoize = memo != nullptr && pushed;
+    if (memoize || output != nullptr) {
+        // The cache and the caller share one payload
+        Message result = node->pullMessage();
+        if (memoize) {
+            memo->store(memoKey, std::move(input), result.payload());
+        }
+        if (output != nullptr) {
+            *output = std::move(result);
+        }
+    }
+    return pushed;
+}
+
+bool Linker::deliver(NodeSlot& target, nlohmann::json data, Message* output) {
+    if (target.memo.load(std::memory_order_acquire) != nullptr) {
+        // The cache keeps the input, so it travels as a shared Message
+        return deliver(target, Message(std::move(data)), output);
+    }
+    std::unique_lock<std::recursive_mutex> lock;
+    Node* node = lockNode(target, lock);
+    setMemoizedOutput(target, Message());
+    bool pushed = node->push(std::move(data));
+    ++target.version;
+    if (output != nullptr) {
+        *output = node->pullMessage();
+    }
+    return pushed;
+}
+
+Message Linker::memoizedOutput(NodeSlot& nodeSlot) {
+    if (!nodeSlot.memoServed.load(std::memory_order_acquire)) {
+        return Message();
+    }
+    std::lock_guard<std::mutex> lock(nodeSlot.memoOutputMutex);
+    return nodeSlot.memoOutput;
+}
+
+void Linker::setMemoizedOutput(NodeSlot& nodeSlot, Message output) {
+    const bool served = output.useCount() > 0;
+    if (!served && !nodeSlot.memoServed.load(std::memory_order_acquire)) {
+        return; // Nothing to clear: the common case costs no lock
+    }
+    std::lock_guard<std::mutex> lock(nodeSlot.memoOutputMutex);
+    nodeSlot.memoOutput = std::move(output);
+    nodeSlot.memoServed.store(served, std::memory_order_release);
+}
+
+// Pushes to a node and pulls its output while holding the node's lock
+NodeResult Linker::executeNode(const std::string& nodeId, nlohmann::json data) {
+    NodeRef ref = resolve(nodeId);
+    if (!ref.valid()) {
+        return unknownNodeResult(nodeId);
+    }
+    return executeNode(ref, std::move(data));
+}
+
+NodeResult Linker::executeNode(NodeRef ref, nlohmann::json data) {
+    NodeResult result;
+    NodeSlot* target = slot(ref);
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Invalid destination NodeRef." << std::endl;
+        result.output = {{"success", false}, {"error_message", "Invalid node handle."}};
+        return result;
+    }
+
+    // The node (and memo cache) in use stay alive if they are replaced meanwhile
+    EpochReclaimer::ReadScope scope;
+    std::cout << "Linker: Sending data to Node '" << target->id << "'" << std::endl;
+    try {
+        Message output;
+        result.success = deliver(*target, std::move(data), &output);
+        result.output = output.take(); // Moved unless the node or its memo cache still shares it
+    } catch (const std::exception& e) {
+        // A failing branch must not take down the other branches of a fan-out
+        std::cerr << "Linker Error: Node '" << target->id << "' threw during push: " << e.what() << std::endl;
+        result.success = false;
+        result.output = {{"success", false}, {"error_message", e.what()}};
+    }
+    return result;
+}
+
+NodeResult Linker::executeNode(NodeRef ref, Message message) {
+    NodeResult result;
+    NodeSlot* target = slot(ref);
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Invalid destination NodeRef." << std::endl;
+        result.output = {{"success", false}, {"error_message", "Invalid node handle."}};
+        return result;
+    }
+    if (message.expired()) {
+        std::cerr << "Linker Warning: Message for Node '" << target->id << "' is past its deadline; dropped." << std::endl;
+        result.output = {{"success", false}, {"error_message", "Deadline exceeded."}};
+        return result;
+    }
+    if (message.cancellation.cancelled()) {
+        result.output = {{"success", false}, {"error_message", "Cancelled."}};
+        return result;
+    }
+
+    EpochReclaimer::ReadScope scope;
+    std::cout << "Linker: Sending message to Node '" << target->id << "'" << std::endl;
+    // Requests the node makes on this thread can be aborted through the token
+    CancellationToken::Scope cancellationScope(message.cancellation);
+    // ...and its API requests queue by the message's priority and deadline
+    Schedule::Scope scheduleScope(message.schedule());
+    try {
+        Message output;
+        result.success = deliver(*target, std::move(message), &output);
+        result.output = output.take();
+    } catch (const std::exception& e) {
+        std::cerr << "Linker Error: Node '" << target->id << "' threw during push: " << e.what() << std::endl;
+        result.success = false;
+        result.output = {{"success", false}, {"error_message", e.what()}};
+    }
+    return result;
+}
+
+NodeResult Linker::executeNodeStreaming(NodeRef ref, nlohmann::json data, const ChunkCallback& onChunk) {
+    NodeResult result;
+    NodeSlot* target = slot(ref);
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Invalid destination NodeRef." << std::endl;
+        result.output = {{"success", false}, {"error_message", "Invalid node handle."}};
+        return result;
+    }
+
+    // The node (and memo cache) in use stay alive if they are replaced meanwhile
+    EpochReclaimer::ReadScope scope;
+    MemoCache* memo = target->memo.load(std::memory_order_acquire);
+    uint64_t memoKey = 0;
+    MemoCache::Input input;
+    if (memo != nullptr) {
+        memoKey = memo->keyOf(data);
+        if (MemoCache::Output cached = memo->lookup(memoKey, data)) {
+            // Reported in one piece, like a node without partial output
+            std::cout << "Linker: Reusing memoized output of Node '" << target->id << "'" << std::endl;
+            if (cached->contains("generated_text") && (*cached)["generated_text"].is_string()) {
+                onChunk((*cached)["generated_text"].get<std::string>());
+            }
+            result.success = true;
+            result.output = *cached;
+            setMemoizedOutput(*target, Message().derive(target->id, std::move(cached)));
+            return result;
+        }
+        // pushStreaming() consumes the input, so the cache keeps its own copy
+        input = std::make_shared<nlohmann::json>(data);
+    }
+
+    std::unique_lock<std::recursive_mutex> lock;
+    Node* node = lockNode(*target, lock);
+    std::cout << "Linker: Streaming data to Node '" << target->id << "'" << std::endl;
+    try {
+        setMemoizedOutput(*target, Message());
+        result.success = node->pushStreaming(std::move(data), onChunk);
+        ++target->version;
+        Message output = node->pullMessage();
+        if (memo != nullptr && result.success) {
+            memo->store(memoKey, std::move(input), output.payload());
+        }
+        result.output = output.take();
+    } catch (const std::exception& e) {
+        std::cerr << "Linker Error: Node '" << target->id << "' threw during push: " << e.what() << std::endl;
+        result.success = false;
+        result.output = {{"success", false}, {"error_message", e.what()}};
+    }
+    return result;
 }
 
 bool Linker::send(const std::string& toId, const std::string& fromId) {
-    nlohmann::json data = Linker::getInstance().fetch(fromId);
+    NodeRef to = resolve(toId);
+    NodeSlot* from = slot(resolve(fromId));
+    if (!to.valid() || from == nullptr) {
+        std::cerr << "Linker Error: Cannot send from '" << fromId << "' to '" << toId << "': unknown Node." << std::endl;
+        return false;
+    }
 
-    return Linker::getInstance().sendData(toId, data);
+    Message message = memoizedOutput(*from);
+    if (message.useCount() == 0) {
+        EpochReclaimer::ReadScope scope;
+        std::unique_lock<std::recursive_mutex> lock;
+        Node* node = lockNode(*from, lock);
+        message = node->pullMessage();
+    }
+    return sendMessage(to, std::move(message));
 }
 
 // Sends data through a sequence of Nodes, where output of one becomes input for the next
@@ -155,75 +849,929 @@ bool Linker::sendDataStream(const std::vector<std::string>& nodeIds, nlohmann::j
         return false;
     }
 
-    nlohmann::json currentData = initialData;
+    // Each hop's output Message is the next hop's input, so payloads a node
+    // keeps in a Message (e.g. Agent) are passed on without a copy
+    Message current(std::move(initialData));
     bool success = true;
 
     for (size_t i = 0; i < nodeIds.size(); ++i) {
         const std::string& nodeId = nodeIds[i];
-        auto it = m_registeredNodes.find(nodeId);
-        if (it == m_registeredNodes.end()) {
+        NodeSlot* currentSlot = slot(resolve(nodeId));
+        if (currentSlot == nullptr) {
             std::cerr << "Linker Error: Node ID '" << nodeId << "' in stream not found." << std::endl;
             success = false;
             break;
         }
 
-        // Access the raw pointer from the unique_ptr
-        Node* currentNode = it->second.get();
+        EpochReclaimer::ReadScope scope;
         std::cout << "Linker: Processing stream - sending data to Node '" << nodeId << "'" << std::endl;
 
-        // Push data to the current node for processing
-        if (!currentNode->push(currentData)) {
+        // Push data to the current node for processing (or answer it from the
+        // node's memo cache); its output becomes the input for the next node.
+        // current is replaced by this output, so it can be moved
+        Message output;
+        if (!deliver(*currentSlot, std::move(current), &output)) {
             std::cerr << "Linker Error: Node '" << nodeId << "' failed to process input data during stream." << std::endl;
             success = false;
             break;
         }
-
-        // Pull processed data from the current node to be used as input for the next node in the stream
-        currentData = currentNode->pull();
+        current = std::move(output);
         std::cout << "Linker: Received processed data from Node '" << nodeId << "'" << std::endl;
     }
     return success;
 }
 
 bool Linker::sendStream(const std::vector<std::string>& nodeIds, const std::string& fromId) {
-    nlohmann::json data = Linker::getInstance().fetch(fromId);
+    nlohmann::json data = Linker::getInstance().fetch(fromId).take();
+
+    return Linker::getInstance().sendDataStream(nodeIds, std::move(data));
+}
+
+// Runs a stream of inputs through a sequence of Nodes, one thread per stage
+bool Linker::sendDataStreamPipelined(const std::vector<std::string>& nodeIds, PipelineSource source,
+                                     PipelineSink sink, PipelineOptions options) {
+    if (nodeIds.empty()) {
+        std::cerr << "Linker Error: sendDataStreamPipelined called with empty node ID list." << std::endl;
+        return false;
+    }
+    // Resolved once; the stages route every item by handle
+    std::vector<NodeRef> refs;
+    for (const std::string& nodeId : nodeIds) {
+        refs.push_back(resolve(nodeId));
+        if (!refs.back().valid()) {
+            std::cerr << "Linker Error: Node ID '" << nodeId << "' in stream not found." << std::endl;
+            return false;
+        }
+    }
+
+    // An item travelling down the pipeline; result.output is its current data
+    struct PipelineItem {
+        size_t index = 0;
+        NodeResult result;
+    };
+
+    // queues[i] feeds stage i; queues.back() feeds the sink
+    std::vector<std::unique_ptr<BoundedQueue<PipelineItem>>> queues;
+    for (size_t i = 0; i <= nodeIds.size(); ++i) {
+        queues.push_back(std::make_unique<BoundedQueue<PipelineItem>>(options.queueCapacity));
+    }
+
+    // Cancelled if the sink throws, along with the caller's own token
+    CancellationToken cancellation = CancellationToken::create(CancellationToken::current());
+    PipelineThreads<PipelineItem> threads(queues, cancellation);
+
+    // Feeder: reads the source into the first queue
+    threads.spawn([&source, &queues] {
+        size_t index = 0;
+        try {
+            PipelineItem item;
+            while (source(item.result.output)) {
+                item.index = index++;
+                item.result.success = true;
+                if (!queues.front()->push(std::move(item))) {
+                    break;
+                }
+                item = PipelineItem();
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Linker Error: Pipeline source threw: " << e.what() << std::endl;
+        }
+        queues.front()->close();
+    });
+
+    // Stages: each one owns a node and works on one item at a time
+    for (size_t stage = 0; stage < nodeIds.size(); ++stage) {
+        threads.spawn([this, &nodeIds, &refs, &queues, &cancellation, stage] {
+            CancellationToken::Scope cancellationScope(cancellation);
+            BoundedQueue<PipelineItem>& in = *queues[stage];
+            BoundedQueue<PipelineItem>& out = *queues[stage + 1];
+            PipelineItem item;
+            while (in.pop(item)) {
+                if (item.result.success && !cancellation.cancelled()) {
+                    item.result = executeNode(refs[stage], std::move(item.result.output));
+                    if (!item.result.success) {
+                        std::cerr << "Linker Error: Node '" << nodeIds[stage] << "' failed to process pipeline item "
+                                  << item.index << "." << std::endl;
+                    }
+                }
+                out.push(std::move(item));
+            }
+            out.close();
+        });
+    }
+
+    // Sink: on the calling thread; ordered mode holds early items until their turn
+    bool success = true;
+    std::map<size_t, NodeResult> reorderBuffer;
+    size_t nextIndex = 0;
+    PipelineItem item;
+    while (queues.back()->pop(item)) {
+        success = success && item.result.success;
+        if (!options.ordered) {
+            sink(item.index, item.result);
+            continue;
+        }
+        reorderBuffer.emplace(item.index, std::move(item.result));
+        for (auto it = reorderBuffer.find(nextIndex); it != reorderBuffer.end(); it = reorderBuffer.find(nextIndex)) {
+            sink(nextIndex, it->second);
+            reorderBuffer.erase(it);
+            ++nextIndex;
+        }
+    }
+
+    threads.join();
+    return success;
+}
+
+std::vector<NodeResult> Linker::sendDataStreamBatch(const std::vector<std::string>& nodeIds,
+                                                    const std::vector<nlohmann::json>& inputs,
+                                                    size_t queueCapacity) {
+    std::vector<NodeResult> results(inputs.size());
+    size_t next = 0;
+    PipelineOptions options;
+    options.ordered = false; // Results are placed by index, so arrival order does not matter
+    options.queueCapacity = queueCapacity;
+
+    sendDataStreamPipelined(
+        nodeIds,
+        [&inputs, &next](nlohmann::json& input) {
+            if (next >= inputs.size()) {
+                return false;
+            }
+            input = inputs[next++];
+            return true;
+        },
+        [&results](size_t index, const NodeResult& result) { results[index] = result; },
+        options);
+    return results;
+}
+
+// Runs a chain of nodes over streaming edges, one thread per stage
+NodeResult Linker::sendDataStreamIncremental(const std::vector<std::string>& nodeIds, nlohmann::json initialData,
+                                             const std::vector<ChunkGranularity>& edgeGranularity,
+                                             const ChunkCallback& sink) {
+    NodeResult failed;
+    if (nodeIds.empty()) {
+        std::cerr << "Linker Error: sendDataStreamIncremental called with empty node ID list." << std::endl;
+        failed.output = {{"success", false}, {"error_message", "Empty node list."}};
+        return failed;
+    }
+    std::vector<NodeRef> refs;
+    for (const std::string& nodeId : nodeIds) {
+        refs.push_back(resolve(nodeId));
+        if (!refs.back().valid()) {
+            std::cerr << "Linker Error: Node ID '" << nodeId << "' in stream not found." << std::endl;
+            failed.output = {{"success", false}, {"error_message", "Node '" + nodeId + "' not found."}};
+            return failed;
+        }
+    }
+
+    // queues[i] holds the inputs of stage i; queues.back() holds the final output pieces
+    std::vector<std::unique_ptr<BoundedQueue<nlohmann::json>>> queues;
+    for (size_t i = 0; i <= nodeIds.size(); ++i) {
+        queues.push_back(std::make_unique<BoundedQueue<nlohmann::json>>(CHUNK_QUEUE_CAPACITY));
+    }
+    queues.front()->push(std::move(initialData));
+    queues.front()->close();
+
+    std::atomic<bool> stopped{false};
+    std::mutex failureMutex;
+    NodeResult failure; // First failed stage's result
+
+    // Cancelled if the sink throws, along with the caller's own token
+    CancellationToken cancellation = CancellationToken::create(CancellationToken::current());
+    PipelineThreads<nlohmann::json> stages(queues, cancellation);
+    for (size_t stage = 0; stage < nodeIds.size(); ++stage) {
+        stages.spawn([&, stage] {
+            CancellationToken::Scope cancellationScope(cancellation);
+            BoundedQueue<nlohmann::json>& in = *queues[stage];
+            BoundedQueue<nlohmann::json>& out = *queues[stage + 1];
+            const bool last = stage + 1 == nodeIds.size();
+            ChunkGranularity granularity = last ? ChunkGranularity::Token
+                : (stage < edgeGranularity.size() ? edgeGranularity[stage] : ChunkGranularity::Full);
+            StreamChunker chunker(granularity, [&out, last](const std::string& chunk) {
+                out.push(last ? nlohmann::json(chunk) : nlohmann::json{{"content", chunk}});
+            });
+
+            nlohmann::json input;
+            while (in.pop(input)) {
+                if (stopped || cancellation.cancelled()) {
+                    continue; // Drain so the upstream stage is not blocked
+                }
+                NodeResult result = executeNodeStreaming(refs[stage], std::move(input),
+                                                         [&chunker](const std::string& piece) { chunker.feed(piece); });
+                if (!result.success) {
+                    std::cerr << "Linker Error: Node '" << nodeIds[stage] << "' failed during incremental stream." << std::endl;
+                    std::lock_guard<std::mutex> lock(failureMutex);
+                    if (!stopped.exchange(true)) {
+                        failure = std::move(result);
+                    }
+                }
+            }
+            if (!stopped) {
+                chunker.finish();
+            }
+            out.close();
+        });
+    }
 
-    return Linker::getInstance().sendDataStream(nodeIds, data);
+    // Final output pieces go to the sink on the calling thread
+    std::string text;
+    nlohmann::json piece;
+    while (queues.back()->pop(piece)) {
+        const std::string& chunk = piece.get_ref<const std::string&>();
+        text += chunk;
+        if (sink) {
+            sink(chunk);
+        }
+    }
+    stages.join();
+
+    if (stopped) {
+        return failure;
+    }
+    NodeResult result;
+    result.success = true;
+    result.output = {{"success", true}, {"generated_text", text}};
+    return result;
+}
+
+// Sends the same data to multiple target Nodes concurrently and gathers their outputs
+GatherResult Linker::sendDataMulti(const std::vector<std::string>& toIds, nlohmann::json data) {
+    return sendMessageMulti(toIds, Message(std::move(data)));
 }
 
-// Sends the same data to multiple target Nodes
-bool Linker::sendDataMulti(const std::vector<std::string>& toIds, nlohmann::json data) {
+GatherResult Linker::sendMessageMulti(const std::vector<std::string>& toIds, Message message) {
+    GatherResult results;
     if (toIds.empty()) {
         std::cerr << "Linker Warning: sendMulti called with empty destination list. No data sent." << std::endl;
-        return true;
+        return results;
     }
 
-    bool allSentSuccessfully = true;
+    // Each node is pushed once, even if it is listed several times
+    std::vector<std::string> targets;
+    std::set<std::string> seen;
     for (const std::string& toId : toIds) {
-        // Reuse the single send method for each recipient
-        if (!sendData(toId, data)) { // send() already handles unique_ptr dereferencing
-            allSentSuccessfully = false; // If any single send fails, the overall multi-send fails
+        if (seen.insert(toId).second) {
+            targets.push_back(toId);
+        }
+    }
+
+    // Submit every target but the last to the executor; the calling thread
+    // handles the last one instead of just waiting. Every task gets its own
+    // Message, and all of them share one payload.
+    Schedule::Scope scheduleScope(message.schedule()); // The branches queue by the message's schedule
+    Executor& executor = Executor::getInstance();
+    std::vector<std::future<NodeResult>> pending;
+    pending.reserve(targets.size() - 1);
+    for (size_t i = 0; i + 1 < targets.size(); ++i) {
+        pending.push_back(executor.async([this, ref = resolve(targets[i]), &targets, message, i]() mutable {
+            return ref.valid() ? executeNode(ref, std::move(message)) : unknownNodeResult(targets[i]);
+        }));
+    }
+    NodeRef lastRef = resolve(targets.back());
+    results[targets.back()] = lastRef.valid() ? executeNode(lastRef, std::move(message))
+                                              : unknownNodeResult(targets.back());
+
+    for (size_t i = 0; i + 1 < targets.size(); ++i) {
+        results[targets[i]] = executor.await(pending[i]);
+    }
+    return results;
+}
+
+GatherResult Linker::sendMulti(const std::vector<std::string>& nodeIds, const std::string& fromId) {
+    // The fetched payload is shared by every target
+    return Linker::getInstance().sendMessageMulti(nodeIds, Linker::getInstance().fetch(fromId));
+}
+
+bool Linker::allSucceeded(const GatherResult& results) {
+    for (const auto& [nodeId, result] : results) {
+        if (!result.success) {
+            return false;
         }
     }
-    return allSentSuccessfully;
-    
+    return true;
 }
 
-bool Linker::sendMulti(const std::vector<std::string>& nodeIds, const std::string& fromId) {
-    nlohmann::json data = Linker::getInstance().fetch(fromId);
+JoinResult Linker::sendDataJoin(const std::vector<std::string>& toIds, nlohmann::json data,
+                                const JoinPolicy& policy, JoinMerge merge) {
+    return sendMessageJoin(toIds, Message(std::move(data)), policy, std::move(merge));
+}
+
+JoinResult Linker::sendMessageJoin(const std::vector<std::string>& toIds, Message message,
+                                   const JoinPolicy& policy, JoinMerge merge) {
+    JoinResult joinResult;
+
+    // Each node runs once, even if it is listed several times
+    std::vector<std::string> targets;
+    std::set<std::string> seen;
+    for (const std::string& toId : toIds) {
+        if (seen.insert(toId).second) {
+            targets.push_back(toId);
+        }
+    }
+    const size_t total = targets.size();
+
+    // Successes (FirstK) or agreeing votes (Quorum) that decide the join
+    size_t needed = total;
+    if (policy.mode == JoinMode::FirstK) {
+        needed = policy.k > 0 ? policy.k : 1;
+    } else if (policy.mode == JoinMode::Quorum) {
+        needed = policy.k > 0 ? policy.k : total / 2 + 1;
+    }
+    if (total == 0 || needed > total) {
+        std::cerr << "Linker Error: Join over " << total << " node(s) cannot need " << needed << " of them." << std::endl;
+        joinResult.output = {{"success", false}, {"error_message", "Invalid join: not enough branches."}};
+        return joinResult;
+    }
+    if (!merge) {
+        merge = defaultJoinMerge(policy);
+    }
+
+    // One token for all branches; a cancelled caller cancels it too
+    CancellationToken token = CancellationToken::create(message.cancellation);
+    message.cancellation = token;
+
+    auto state = std::make_shared<JoinState>();
+    state->done.assign(total, false);
+    std::future<void> decided = state->decision.get_future();
+
+    // Every branch goes to the executor, so the caller can return while
+    // stragglers are still being cancelled
+    Schedule::Scope scheduleScope(message.schedule());
+    Executor& executor = Executor::getInstance();
+    for (size_t i = 0; i < total; ++i) {
+        executor.submit([this, state, policy, needed, total, token, message, i,
+                         ref = resolve(targets[i]), nodeId = targets[i]]() mutable {
+            NodeResult result = ref.valid() ? executeNode(ref, std::move(message)) : unknownNodeResult(nodeId);
+            if (result.success && !policy.accept(result.output)) {
+                std::cerr << "Linker Warning: Join branch '" << nodeId << "' rejected by the acceptance test." << std::endl;
+                result.success = false;
+                result.output["success"] = false;
+                result.output["error_message"] = "Rejected by the join's acceptance test.";
+            }
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->done[i] = true;
+            if (state->decided) {
+                return; // Straggler: the join no longer needs this result
+            }
+            result.success ? ++state->succeeded : ++state->failed;
+            state->finished.push_back({nodeId, std::move(result)});
+            if (decideJoin(*state, policy, needed, total)) {
+                state->decided = true;
+                if (policy.cancelStragglers && state->finished.size() < total) {
+                    token.cancel();
+                }
+                state->decision.set_value();
+            }
+        });
+    }
+    executor.await(decided);
+
+    std::vector<JoinBranch> winners;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        joinResult.success = state->success;
+        joinResult.branches = state->finished;
+        winners = state->winners;
+        for (size_t i = 0; i < total; ++i) {
+            if (!state->done[i]) {
+                joinResult.cancelled.push_back(targets[i]);
+            }
+        }
+    }
+    std::cout << "Linker: Join decided after " << joinResult.branches.size() << " of " << total
+              << " branches (" << (joinResult.success ? "success" : "failure") << ")." << std::endl;
 
-    return Linker::getInstance().sendDataMulti(nodeIds, data);
+    try {
+        joinResult.output = merge(winners);
+    } catch (const std::exception& e) {
+        std::cerr << "Linker Error: Join merge failed: " << e.what() << std::endl;
+        joinResult.success = false;
+        joinResult.output = nlohmann::json::object();
+    }
+    if (!joinResult.output.is_object()) {
+        joinResult.output = {{"result", std::move(joinResult.output)}};
+    }
+    joinResult.output["success"] = joinResult.success;
+    if (!joinResult.success && joinResult.output.value("error_message", "").empty()) {
+        joinResult.output["error_message"] = "Join failed: " + std::to_string(winners.size()) + " of " +
+            std::to_string(total) + " branches agreed or succeeded, " + std::to_string(needed) + " needed.";
+    }
+    return joinResult;
 }
 
-nlohmann::json Linker::fetch(const std::string& nodeId) {
-    auto it = m_registeredNodes.find(nodeId);
-    if (it == m_registeredNodes.end()) {
+Message Linker::fetch(const std::string& nodeId) {
+    NodeRef ref = resolve(nodeId);
+    if (!ref.valid()) {
         std::cerr << "Linker Error: Destination Node ID '" << nodeId << "' not found." << std::endl;
+        return Message();
+    }
+    return fetch(ref);
+}
+
+Message Linker::fetch(NodeRef ref) {
+    NodeSlot* target = slot(ref);
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Invalid NodeRef." << std::endl;
+        return Message();
+    }
+
+    std::cout << "Linker: Fetching data from Node '" << target->id << "'" << std::endl;
+    Message memoized = memoizedOutput(*target);
+    if (memoized.useCount() > 0) {
+        return memoized;
+    }
+    EpochReclaimer::ReadScope scope;
+    std::unique_lock<std::recursive_mutex> lock;
+    Node* node = lockNode(*target, lock);
+    return node->pullMessage();
+}
+
+// Posts to a node's mailbox
+bool Linker::post(const std::string& toId, nlohmann::json data, std::function<void(const NodeResult&)> onReply,
+                  const Schedule& schedule) {
+    NodeRef to = resolve(toId);
+    if (!to.valid()) {
+        std::cerr << "Linker Error: Destination Node ID '" << toId << "' not found." << std::endl;
+        if (onReply) {
+            NodeResult failed;
+            failed.output = {{"success", false}, {"error_message", "Node '" + toId + "' not found."}};
+            onReply(failed);
+        }
+        return false;
+    }
+    return post(to, std::move(data), std::move(onReply), schedule);
+}
+
+bool Linker::post(NodeRef to, nlohmann::json data, std::function<void(const NodeResult&)> onReply,
+                  const Schedule& schedule) {
+    NodeSlot* target = slot(to);
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Invalid destination NodeRef." << std::endl;
+        if (onReply) {
+            NodeResult failed;
+            failed.output = {{"success", false}, {"error_message", "Invalid node handle."}};
+            onReply(failed);
+        }
+        return false;
     }
+    // Hold an admission slot until the reply arrives (or the message is rejected or dropped)
+    m_admission.acquire(schedule);
+    auto admitted = [this, onReply = std::move(onReply)](const NodeResult& result) {
+        m_admission.release();
+        if (onReply) {
+            onReply(result);
+        }
+    };
+    return target->actor->post({std::move(data), std::move(admitted), schedule});
+}
 
-    // Access the raw pointer from the unique_ptr to call push()
-    Node* targetNode = it->second.get();
-    std::cout << "Linker: Fetching data from Node '" << nodeId << "'" << std::endl;
-    return targetNode->pull();
+bool Linker::forward(NodeRef to, nlohmann::json data) {
+    NodeSlot* target = slot(to);
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Invalid destination NodeRef." << std::endl;
+        return false;
+    }
+    return target->actor->post({std::move(data), nullptr});
+}
 
+bool Linker::configureMemo(const std::string& nodeId, const MemoConfig& config, uint64_t configVersion) {
+    NodeSlot* target = slot(resolve(nodeId));
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Cannot memoize unknown Node '" << nodeId << "'." << std::endl;
+        return false;
+    }
+    EpochReclaimer::getInstance().retire(
+        target->memo.exchange(new MemoCache(config, configVersion), std::memory_order_acq_rel));
+    std::cout << "Linker: Memoizing outputs of Node '" << nodeId << "' (up to " << config.maxEntries << " entries)." << std::endl;
+    return true;
+}
+
+bool Linker::hostInWorker(const std::string& nodeId, const WorkerConfig& config) {
+    if (WorkerHost::active()) {
+        return true; // This is the worker: the node itself runs here
+    }
+    NodeSlot* target = slot(resolve(nodeId));
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Cannot move unknown Node '" << nodeId << "' to a worker." << std::endl;
+        return false;
+    }
+    // The in-process instance is replaced by a proxy; the slot (and so every
+    // NodeRef) and its memo cache stay
+    auto remote = std::make_unique<RemoteNode>(WorkerSupervisor::getInstance().launch(nodeId, config));
+    EpochReclaimer::getInstance().retire(target->node.exchange(remote.release(), std::memory_order_acq_rel));
+    std::cout << "Linker: Node '" << nodeId << "' runs in a worker process." << std::endl;
+    return true;
+}
+
+bool Linker::configureMailbox(const std::string& nodeId, const MailboxConfig& config) {
+    NodeSlot* target = slot(resolve(nodeId));
+    if (target == nullptr) {
+        std::cerr << "Linker Error: Cannot configure the mailbox of unknown Node '" << nodeId << "'." << std::endl;
+        return false;
+    }
+    target->actor->configure(config);
+    return true;
+}
+
+size_t Linker::inFlight() const {
+    return m_admission.inFlight();
+}
+
+std::future<NodeResult> Linker::ask(const std::string& toId, nlohmann::json data, const Schedule& schedule) {
+    auto promise = std::make_shared<std::promise<NodeResult>>();
+    std::future<NodeResult> future = promise->get_future();
+    post(toId, std::move(data), [promise](const NodeResult& result) {
+        promise->set_value(result);
+    }, schedule);
+    return future;
+}
+
+bool Linker::subscribe(const std::string& fromId, const std::string& toId) {
+    NodeSlot* from = slot(resolve(fromId));
+    NodeRef to = resolve(toId);
+    if (from == nullptr || !to.valid()) {
+        std::cerr << "Linker Error: Cannot subscribe '" << toId << "' to '" << fromId << "': unknown Node." << std::endl;
+        return false;
+    }
+    from->actor->addSubscriber(to);
+    return true;
+}
+
+bool Linker::subscribe(const std::string& fromId, NodeActor::OutputListener listener) {
+    NodeSlot* from = slot(resolve(fromId));
+    if (from == nullptr) {
+        std::cerr << "Linker Error: Cannot subscribe to unknown Node '" << fromId << "'." << std::endl;
+        return false;
+    }
+    from->actor->addListener(std::move(listener));
+    return true;
+}
+
+bool Linker::hasGraph(const std::string& graphId) const {
+    return m_graphs.count(graphId) > 0;
+}
+
+GraphResult Linker::runGraph(const std::string& graphId, nlohmann::json input, const Schedule& schedule) {
+    return runGraph(graphId, std::move(input), nullptr, schedule);
+}
+
+// Runs a graph: dispatches every step whose dependencies are done, then waits
+// for any running step to finish before dispatching the steps it unblocked.
+GraphResult Linker::runGraph(const std::string& graphId, nlohmann::json input, const ChunkCallback& onOutputChunk,
+                             const Schedule& schedule) {
+    auto graphIt = m_graphs.find(graphId);
+    if (graphIt == m_graphs.end()) {
+        std::cerr << "Linker Error: Graph '" << graphId << "' not found." << std::endl;
+        return GraphResult();
+    }
+    // The steps are submitted to the executor, which hands the schedule on to them
+    Schedule::Scope scheduleScope(schedule);
+
+    // Run context: graph input plus every finished step's output
+    nlohmann::json context = nlohmann::json::object();
+    context["input"] = std::move(input);
+    if (!m_checkpointer) {
+        return runGraphSteps(graphIt->second, context, nullptr, nullptr, onOutputChunk);
+    }
+
+    // Journaled run: steps this run (same graph and node definitions, same
+    // input) completed before a restart are not run again, and each step that
+    // completes now is journaled
+    const Graph& graph = graphIt->second;
+    const std::vector<GraphStep>& steps = graph.getSteps();
+    uint64_t version = graph.getVersion();
+    for (const GraphStep& step : steps) {
+        NodeSlot* stepSlot = slot(step.node);
+        uint64_t nodeVersion = stepSlot ? stepSlot->configVersion.load(std::memory_order_relaxed) : 0;
+        version ^= nodeVersion + 0x9e3779b97f4a7c15ULL + (version << 6) + (version >> 2); // boost::hash_combine style
+    }
+    const std::string runKey = Checkpointer::runKey(graphId, version, context["input"]);
+    const std::map<std::string, NodeResult> journaled = m_checkpointer->journaledSteps(runKey);
+    StepReuse reuse = [&](size_t index, nlohmann::json& stepInput, NodeResult& reused) {
+        auto journaledIt = journaled.find(steps[index].id);
+        if (journaledIt != journaled.end() && journaledIt->second.success) {
+            reused = journaledIt->second;
+            return true;
+        }
+        stepInput = graph.buildInput(index, context);
+        return false;
+    };
+    StepDone journal = [&](size_t index, const NodeResult& stepResult) {
+        m_checkpointer->journalStep(runKey, steps[index].id, stepResult);
+    };
+    GraphResult result = runGraphSteps(graph, context, reuse, journal, onOutputChunk);
+    if (result.success) {
+        m_checkpointer->finishRun(runKey); // A failed run keeps its journal for a retry, until it expires
+    }
+    return result;
+}
+
+bool Linker::checkpoint(bool wait) {
+    if (!m_checkpointer) {
+        return false;
+    }
+    captureCheckpoint();
+    if (wait) {
+        m_checkpointer->flush();
+    }
+    return true;
+}
+
+// Saves only the slots pushed to since their last save. A node that is busy
+// right now is left for the next checkpoint rather than waited for.
+void Linker::captureCheckpoint() {
+    std::lock_guard<std::mutex> captureLock(m_checkpointMutex);
+    EpochReclaimer::ReadScope scope;
+    const NodeTable* table = m_table.load(std::memory_order_acquire);
+    for (NodeSlot* nodeSlot : table->slots) {
+        uint64_t version = nodeSlot->version.load();
+        if (version == nodeSlot->savedVersion) {
+            continue;
+        }
+        std::unique_lock<std::recursive_mutex> lock;
+        Node* node = lockNode(*nodeSlot, lock, true);
+        if (node == nullptr) {
+            continue;
+        }
+        if (lock.owns_lock()) {
+            version = nodeSlot->version.load(); // Stable while the lock is held
+        }
+        m_checkpointer->saveNode(nodeSlot->id, node->saveState());
+        nodeSlot->savedVersion = version;
+    }
+}
+
+std::unique_ptr<GraphSession> Linker::openGraphSession(const std::string& graphId) {
+    auto graphIt = m_graphs.find(graphId);
+    if (graphIt == m_graphs.end()) {
+        std::cerr << "Linker Error: Graph '" << graphId << "' not found." << std::endl;
+        return nullptr;
+    }
+    return std::make_unique<GraphSession>(graphIt->second);
+}
+
+GraphResult Linker::runGraphSteps(const Graph& graph, nlohmann::json& context, const StepReuse& reuse,
+                                  const StepDone& onStepDone, const ChunkCallback& onOutputChunk) {
+    GraphResult result;
+    const std::string& graphId = graph.getId();
+    const std::vector<GraphStep>& steps = graph.getSteps();
+    // Read by steps on streamed edges; other entries may be added meanwhile
+    const nlohmann::json& graphInput = context["input"];
+
+    std::vector<size_t> remaining(steps.size());
+    std::vector<bool> skipped(steps.size(), false);
+    std::vector<bool> wasReused(steps.size(), false);
+    // Runs inside the step feeding it over a streamed edge, which reports its result
+    std::vector<bool> carried(steps.size(), false);
+    std::vector<size_t> carriedReady;
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < steps.size(); ++i) {
+        remaining[i] = steps[i].dependencies.size();
+        if (remaining[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    // Finished steps are reported back to this thread through a small queue
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    std::vector<std::pair<size_t, NodeResult>> done;
+    size_t inFlight = 0;
+    Executor& executor = Executor::getInstance();
+    bool success = true;
+
+    // Marks a failed step's whole downstream as skipped
+    std::function<void(size_t)> skipDownstream = [&](size_t index) {
+        for (size_t dependent : steps[index].dependents) {
+            if (!skipped[dependent]) {
+                skipped[dependent] = true;
+                std::cerr << "Linker Warning: Graph '" << graphId << "' skips step '" << steps[dependent].id << "'." << std::endl;
+                skipDownstream(dependent);
+            }
+        }
+    };
+
+    // A step streams if it feeds a streamed edge or is the output being streamed
+    const bool streamOutput = onOutputChunk && graph.getOutputs().size() == 1;
+    auto streams = [&](size_t index) {
+        if (streamOutput && graph.getOutputs().front() == index) {
+            return true;
+        }
+        for (size_t dependent : steps[index].dependents) {
+            if (steps[dependent].inputGranularity != ChunkGranularity::Full) {
+                return true;
+            }
+        }
+        return false;
+    };
+    std::function<void(size_t)> carryStreamed = [&](size_t index) {
+        for (size_t dependent : steps[index].dependents) {
+            if (steps[dependent].inputGranularity != ChunkGranularity::Full) {
+                carried[dependent] = true;
+                carryStreamed(dependent);
+            }
+        }
+    };
+
+    while (!ready.empty() || inFlight > 0) {
+        // Dispatch everything that is ready
+        for (size_t index : ready) {
+            nlohmann::json stepInput;
+            try {
+                NodeResult reused;
+                if (reuse && reuse(index, stepInput, reused)) {
+                    // Still clean: finishes at once and releases its dependents
+                    result.reused.push_back(steps[index].id);
+                    wasReused[index] = true;
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    done.emplace_back(index, std::move(reused));
+                    ++inFlight;
+                    continue;
+                }
+                if (!reuse) {
+                    stepInput = graph.buildInput(index, context);
+                }
+            } catch (const nlohmann::json::exception& e) {
+                std::cerr << "Linker Error: Graph '" << graphId << "' could not build input for step '" << steps[index].id << "': " << e.what() << std::endl;
+                NodeResult failed;
+                failed.output = {{"success", false}, {"error_message", e.what()}};
+                std::lock_guard<std::mutex> lock(doneMutex);
+                done.emplace_back(index, std::move(failed));
+                ++inFlight;
+                continue;
+            }
+            ++inFlight;
+            const bool streamed = streams(index);
+            if (streamed) {
+                carryStreamed(index);
+            }
+            executor.submit([this, &graph, &steps, &graphInput, &onOutputChunk, &doneMutex, &doneCv, &done, index, streamed,
+                             stepInput = std::move(stepInput)]() mutable {
+                NodeResult stepResult;
+                std::map<size_t, NodeResult> fed;
+                if (Schedule::current().deadline <= Schedule::Clock::now()) {
+                    stepResult.output = {{"success", false}, {"error_message", "Deadline exceeded."}};
+                } else if (streamed) {
+                    std::mutex fedMutex;
+                    stepResult = runStreamedStep(graph, index, std::move(stepInput), graphInput, onOutputChunk, fed, fedMutex);
+                } else {
+                    stepResult = steps[index].node.valid()
+                        ? executeNode(steps[index].node, std::move(stepInput))
+                        : executeNode(steps[index].nodeId, std::move(stepInput)); // Unknown node: reports the error
+                }
+                std::lock_guard<std::mutex> lock(doneMutex);
+                // The steps it fed follow it, upstream first, as long as their source succeeded
+                std::vector<bool> succeeded(steps.size(), false);
+                succeeded[index] = stepResult.success;
+                done.emplace_back(index, std::move(stepResult));
+                for (size_t fedIndex : graph.getTopologicalOrder()) {
+                    auto fedIt = fed.find(fedIndex);
+                    if (fedIt != fed.end() && succeeded[steps[fedIndex].dependencies.front()]) {
+                        succeeded[fedIndex] = fedIt->second.success;
+                        done.emplace_back(fedIndex, std::move(fedIt->second));
+                    }
+                }
+                doneCv.notify_one();
+            });
+        }
+        ready.clear();
+
+        // Wait for at least one step to finish, then release its dependents
+        std::vector<std::pair<size_t, NodeResult>> finished;
+        {
+            // If this graph runs inside a pool task, let the pool know this worker is waiting
+            Executor::BlockingScope blocking;
+            std::unique_lock<std::mutex> lock(doneMutex);
+            doneCv.wait(lock, [&done] { return !done.empty(); });
+            finished.swap(done);
+        }
+        std::vector<bool> reported(steps.size(), false);
+        for (auto& [index, stepResult] : finished) {
+            if (!carried[index]) {
+                --inFlight;
+            }
+            reported[index] = true;
+            const GraphStep& step = steps[index];
+            if (stepResult.success) {
+                if (onStepDone && !wasReused[index]) {
+                    onStepDone(index, stepResult);
+                }
+                context[step.id] = stepResult.output;
+                for (size_t dependent : step.dependents) {
+                    if (--remaining[dependent] == 0 && !skipped[dependent]) {
+                        (carried[dependent] ? carriedReady : ready).push_back(dependent);
+                    }
+                }
+            } else {
+                std::cerr << "Linker Error: Graph '" << graphId << "' step '" << step.id << "' failed." << std::endl;
+                success = false;
+                skipDownstream(index);
+            }
+            result.steps[step.id] = std::move(stepResult);
+        }
+        // A carried step reports with its source; one that got no chunk at all
+        // (an empty text) runs on its own, on the source's whole output
+        for (size_t index : carriedReady) {
+            if (!reported[index]) {
+                carried[index] = false;
+                ready.push_back(index);
+            }
+        }
+        carriedReady.clear();
+    }
+
+    // Collect the graph output
+    const std::vector<size_t>& outputs = graph.getOutputs();
+    if (outputs.size() == 1) {
+        result.output = context.value(steps[outputs.front()].id, nlohmann::json());
+    } else {
+        result.output = nlohmann::json::object();
+        for (size_t index : outputs) {
+            result.output[steps[index].id] = context.value(steps[index].id, nlohmann::json());
+        }
+    }
+    result.success = success && result.steps.size() == steps.size();
+    return result;
+}
+
+NodeResult Linker::runStreamedStep(const Graph& graph, size_t index, nlohmann::json input, const nlohmann::json& graphInput,
+                                   const ChunkCallback& onOutputChunk, std::map<size_t, NodeResult>& fed, std::mutex& fedMutex) {
+    const std::vector<GraphStep>& steps = graph.getSteps();
+    const GraphStep& step = steps[index];
+    if (!step.node.valid()) {
+        return executeNode(step.nodeId, std::move(input)); // Unknown node: reports the error
+    }
+    const bool isOutput = onOutputChunk && graph.getOutputs().size() == 1 && graph.getOutputs().front() == index;
+
+    // One chunker, queue and thread per step fed over a streamed edge
+    std::vector<size_t> targets;
+    for (size_t dependent : step.dependents) {
+        if (steps[dependent].inputGranularity != ChunkGranularity::Full) {
+            targets.push_back(dependent);
+        }
+    }
+    std::vector<std::unique_ptr<BoundedQueue<std::string>>> queues;
+    std::vector<StreamChunker> chunkers;
+    chunkers.reserve(targets.size());
+    for (size_t target : targets) {
+        queues.push_back(std::make_unique<BoundedQueue<std::string>>(CHUNK_QUEUE_CAPACITY));
+        BoundedQueue<std::string>& queue = *queues.back();
+        chunkers.emplace_back(steps[target].inputGranularity, [&queue](const std::string& chunk) { queue.push(chunk); });
+    }
+
+    // Cancelled if this step fails, along with the caller's own token
+    CancellationToken cancellation = CancellationToken::create(CancellationToken::current());
+    PipelineThreads<std::string> threads(queues, cancellation);
+    for (size_t k = 0; k < targets.size(); ++k) {
+        threads.spawn([&, k] {
+            CancellationToken::Scope cancellationScope(cancellation);
+            const size_t target = targets[k];
+            bool failed = false;
+            std::string chunk;
+            while (queues[k]->pop(chunk)) {
+                if (failed || cancellation.cancelled()) {
+                    continue; // Drain so this step is not blocked
+                }
+                // The target sees the chunk as this step's whole output
+                NodeResult part;
+                try {
+                    nlohmann::json chunkContext = {{"input", graphInput},
+                                                   {step.id, {{"success", true}, {"generated_text", std::move(chunk)}}}};
+                    part = runStreamedStep(graph, target, graph.buildInput(target, chunkContext), graphInput,
+                                           onOutputChunk, fed, fedMutex);
+                } catch (const nlohmann::json::exception& e) {
+                    std::cerr << "Linker Error: Graph '" << graph.getId() << "' could not build input for step '"
+                              << steps[target].id << "': " << e.what() << std::endl;
+                    part.output = {{"success", false}, {"error_message", e.what()}};
+                }
+                failed = !part.success;
+                std::lock_guard<std::mutex> lock(fedMutex);
+                foldChunkResult(fed, target, std::move(part));
+            }
+        });
+    }
+
+    NodeResult result = executeNodeStreaming(step.node, std::move(input), [&](const std::string& piece) {
+        if (isOutput) {
+            onOutputChunk(piece);
+        }
+        for (StreamChunker& chunker : chunkers) {
+            chunker.feed(piece);
+        }
+    });
+    if (result.success) {
+        for (StreamChunker& chunker : chunkers) {
+            chunker.finish();
+        }
+    } else {
+        cancellation.cancel();
+    }
+    for (auto& queue : queues) {
+        queue->close();
+    }
+    threads.join();
+    return result;
 }
@@ -4,8 +4,48 @@
 #include <nlohmann/json.hpp>
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
+#include <memory>
+#include <mutex>
 #include "node.h" // Include Node base class
+#include "node_ref.h"
+#include "message.h"
+#include "graph.h"
+#include "graph_session.h"
+#include "actor.h"
+#include "admission.h"
+#include "join_node.h"
+#include "memo_cache.h"
+#include "worker_process.h"
+#include "stream_chunker.h"
+#include "checkpoint.h"
+#include "epoch.h"
+#include <atomic>
+#include <functional>
+#include <future>
+
+// Results of a fan-out, keyed by destination Node ID.
+using GatherResult = std::map<std::string, NodeResult>;
+
+// Settings for a pipelined stream (Linker::sendDataStreamPipelined).
+struct PipelineOptions {
+    bool ordered = true;      // Deliver results in input order; false delivers them as they finish
+    size_t queueCapacity = 4; // Items that may wait between two stages
+};
+
+// Produces the next input of a pipelined stream. Returns false when there are no more.
+using PipelineSource = std::function<bool(nlohmann::json& input)>;
+// Receives the final result of each input, with the input's position in the stream.
+using PipelineSink = std::function<void(size_t index, const NodeResult& result)>;
+
+// Outcome of running a graph.
+struct GraphResult {
+    bool success = false;
+    nlohmann::json output;                  // Output step's result, or an object keyed by step ID if there are several
+    std::map<std::string, NodeResult> steps; // Every step that ran, keyed by step ID
+    std::vector<std::string> reused;         // Steps whose previous result was reused (GraphSession)
+};
 
 class Linker {
 public:
@@ -21,33 +61,289 @@ public:
     // Send data from an implicit source to a single destination Node.
     // Returns true on success, false on failure (e.g., target node not found).
     bool sendData(const std::string& toId, nlohmann::json data);
+    bool sendData(NodeRef to, nlohmann::json data);
+    // Sends a Message envelope; the node receives the shared payload (see Node::pushMessage()).
+    // A message whose deadline has passed is dropped and reported as a failure.
+    bool sendMessage(NodeRef to, Message message);
+    // Forwards fromId's current output to toId as a shared Message, without copying it.
     bool send(const std::string& toId, const std::string& fromId);
 
+    // Interned node handles: resolve an ID once, then route through the NodeRef
+    // (an index into the node table) on every hop.
+    // Returns an invalid NodeRef if no node is registered under nodeId.
+    // Lookups take no lock, so they never wait for a registration.
+    NodeRef resolve(const std::string& nodeId) const;
+    // The registered node, or nullptr if there is none. registerNode() may
+    // replace and free it at any time, so call this inside an
+    // EpochReclaimer::ReadScope and use the pointer only until the scope
+    // closes. The node is not locked either: to read its output, use fetch().
+    Node* getNode(NodeRef ref) const;
+    Node* getNode(const std::string& nodeId) const;
+    // The ID a handle was interned from ("" for an invalid handle).
+    const std::string& getNodeId(NodeRef ref) const;
+
     // Send data through a sequence of Nodes.
     // The data flows: initial_data -> node1 -> node2 -> ... -> last_node_output.
     // Returns true if the entire stream processing was successful.
     bool sendDataStream(const std::vector<std::string>& nodeIds, nlohmann::json initialData);
     bool sendStream(const std::vector<std::string>& nodeIds, const std::string& fromId);
 
-    // Send data to multiple destination Nodes simultaneously.
-    // Each target node receives the same initial data.
-    // Returns true if all sends were successful.
-    bool sendDataMulti(const std::vector<std::string>& toIds, nlohmann::json data);
-    bool sendMulti(const std::vector<std::string>& toIds, const std::string& fromId);
+    // Sends many inputs through the same sequence of Nodes as a pipeline: each
+    // stage has its own thread, so while node2 works on item k, node1 already
+    // works on item k+1. With N stages a batch finishes up to N times sooner
+    // than calling sendDataStream() once per input.
+    // - Stages are connected by bounded queues (options.queueCapacity), so the
+    //   source is only read as fast as the slowest stage drains it.
+    // - An item whose stage fails skips the remaining stages and reaches the
+    //   sink with success == false and that stage's output.
+    // - The sink runs on the calling thread.
+    // Returns true if every node exists and every item went through all stages.
+    bool sendDataStreamPipelined(const std::vector<std::string>& nodeIds, PipelineSource source,
+                                 PipelineSink sink, PipelineOptions options = PipelineOptions());
+    // Convenience form for a fixed batch: returns the results in input order.
+    std::vector<NodeResult> sendDataStreamBatch(const std::vector<std::string>& nodeIds,
+                                                const std::vector<nlohmann::json>& inputs,
+                                                size_t queueCapacity = PipelineOptions().queueCapacity);
 
-    nlohmann::json fetch(const std::string& agentId);
+    // Sends data through a sequence of Nodes over streaming edges: each node's
+    // output is cut into chunks (edgeGranularity[i] for the edge after nodeIds[i])
+    // and every chunk is pushed to the next node as soon as it is complete, as
+    // {"content": chunk}. A downstream node therefore starts on the first sentence
+    // (or paragraph) instead of waiting for the whole text, and a chain's latency
+    // approaches the sum of its first-chunk times. Missing entries mean Full,
+    // which hands over the complete text like sendDataStream().
+    // - Each stage has its own thread and processes its chunks in order; the
+    //   outputs of one stage's chunks are concatenated.
+    // - sink receives the last node's output token by token on the calling thread.
+    // - The first failure stops the chain.
+    // Returns the last node's success flag and {"success", "generated_text"} output.
+    NodeResult sendDataStreamIncremental(const std::vector<std::string>& nodeIds, nlohmann::json initialData,
+                                         const std::vector<ChunkGranularity>& edgeGranularity,
+                                         const ChunkCallback& sink);
 
-    // Public for testing purposes (consider making private with a getter in production)
-    // Now stores unique_ptr to manage memory
-    std::map<std::string, std::unique_ptr<Node>> m_registeredNodes;
-    
+    // Send data to multiple destination Nodes concurrently.
+    // Each target node receives the same initial data; all pushes run in parallel,
+    // so the fan-out takes about as long as the slowest target.
+    // Returns every target's success flag and output, keyed by node ID.
+    GatherResult sendDataMulti(const std::vector<std::string>& toIds, nlohmann::json data);
+    // Same as sendDataMulti(), with an envelope: every target shares the one
+    // payload, so a broadcast costs a reference-count bump per recipient.
+    GatherResult sendMessageMulti(const std::vector<std::string>& toIds, Message message);
+    GatherResult sendMulti(const std::vector<std::string>& toIds, const std::string& fromId);
+
+    // True if every node in a gathered result succeeded.
+    static bool allSucceeded(const GatherResult& results);
+
+    // Fan-out followed by a fan-in: sends the same data to every node, joins the
+    // results under policy and assembles them with merge (nullptr = the policy's
+    // default, see defaultJoinMerge()).
+    // - All waits for every branch.
+    // - FirstK and Quorum return as soon as the outcome is certain, either way,
+    //   and cancel the branches still running (policy.cancelStragglers): their
+    //   HTTP requests are aborted. Racing redundant nodes with a first-1 join
+    //   cuts the tail latency down to the fastest of them.
+    JoinResult sendDataJoin(const std::vector<std::string>& toIds, nlohmann::json data,
+                            const JoinPolicy& policy, JoinMerge merge = nullptr);
+    // Same, with an envelope. Cancelling message.cancellation cancels the whole join.
+    JoinResult sendMessageJoin(const std::vector<std::string>& toIds, Message message,
+                               const JoinPolicy& policy, JoinMerge merge = nullptr);
+
+    // Pushes data to a node and pulls its output as one step, holding the node's
+    // lock in between so a concurrent sender cannot overwrite the output.
+    // data is a sink parameter like Node::push(): pass it with std::move when
+    // it is not needed afterwards. The output is the one copy made per hop.
+    NodeResult executeNode(const std::string& nodeId, nlohmann::json data);
+    NodeResult executeNode(NodeRef ref, nlohmann::json data);
+    NodeResult executeNode(NodeRef ref, Message message);
+
+    // Same as executeNode(), using the node's pushStreaming().
+    NodeResult executeNodeStreaming(NodeRef ref, nlohmann::json data, const ChunkCallback& onChunk);
+
+    // The node's current output as a Message: shared with the node when it keeps
+    // its output in one (e.g. Agent) or with its memo cache, so nothing is
+    // copied; other nodes' pull() is copied once, under the node's lock. An
+    // empty Message if the node does not exist.
+    Message fetch(const std::string& agentId);
+    Message fetch(NodeRef ref);
+
+    // --- Actor mode ---
+    // Posts data to a node's mailbox and returns immediately. Messages to one node
+    // are processed one at a time, in order, on the Executor, so any number of
+    // sessions can share a node without locking around it.
+    // onReply (optional) receives this message's own result.
+    // Each post takes one of the max_in_flight admission slots (base_config.json)
+    // until its reply arrives, and waits for one when all are taken. The target's
+    // mailbox limits ("queue" in its JSON) apply as well.
+    // schedule sets the message's priority class and deadline (see Schedule):
+    // it orders the wait for an admission slot and the node's API requests, and
+    // a message still queued at its deadline is dropped with a failed reply.
+    // Returns false if the node does not exist or its mailbox rejected the message.
+    bool post(const std::string& toId, nlohmann::json data, std::function<void(const NodeResult&)> onReply = nullptr,
+              const Schedule& schedule = Schedule::current());
+    bool post(NodeRef to, nlohmann::json data, std::function<void(const NodeResult&)> onReply = nullptr,
+              const Schedule& schedule = Schedule::current());
+    // Posts data and returns a future for this message's result.
+    std::future<NodeResult> ask(const std::string& toId, nlohmann::json data,
+                                const Schedule& schedule = Schedule::current());
+    // Forwards every successful output of fromId to toId's mailbox.
+    bool subscribe(const std::string& fromId, const std::string& toId);
+    // Node-to-node post used for subscriptions: the work was admitted when it
+    // entered the system, so only the target's mailbox limits apply.
+    bool forward(NodeRef to, nlohmann::json data);
+    // Sets the mailbox limits of a registered node.
+    bool configureMailbox(const std::string& nodeId, const MailboxConfig& config);
+    // Memoizes a registered node's successful outputs: every hop to the node
+    // (sendData, sendMessage, executeNode, streams, graph steps) with an input
+    // seen before (same content, same configVersion) is answered with the stored
+    // output without running the node, and fetch()/send() from the node then
+    // read that output. Only for nodes whose output depends on nothing but
+    // their input and configuration.
+    bool configureMemo(const std::string& nodeId, const MemoConfig& config, uint64_t configVersion);
+    // Moves a registered node into a worker process of its own (see
+    // WorkerProcess): a crash or a CPU-heavy stage there no longer affects the
+    // rest, and the WorkerSupervisor restarts the worker if it exits. The node
+    // keeps its ID and NodeRef. Inside a worker this does nothing.
+    bool hostInWorker(const std::string& nodeId, const WorkerConfig& config);
+    // Requests admitted through post() whose reply has not arrived yet.
+    size_t inFlight() const;
+    // Calls a listener with every output of fromId (e.g. to print the last stage).
+    bool subscribe(const std::string& fromId, NodeActor::OutputListener listener);
+
+    // Runs a graph loaded from the graphs/ directory. Steps start as soon as all
+    // their dependencies have finished, and independent branches run concurrently,
+    // so the run takes about as long as the graph's critical path.
+    // A failed step skips everything downstream of it; other branches still run.
+    // The steps run under schedule (see Schedule), e.g. {Priority::Interactive}
+    // for a user waiting on the answer; steps not started by its deadline fail.
+    GraphResult runGraph(const std::string& graphId, nlohmann::json input,
+                         const Schedule& schedule = Schedule::current());
+    // Same, streaming: onOutputChunk receives the text of the graph's output
+    // step as it is generated (on the thread running that step), and steps on
+    // streamed edges (see Graph) run on their source's chunks meanwhile. A graph
+    // with several output steps streams none of them.
+    GraphResult runGraph(const std::string& graphId, nlohmann::json input, const ChunkCallback& onOutputChunk,
+                         const Schedule& schedule = Schedule::current());
+    bool hasGraph(const std::string& graphId) const;
+    // Opens a reactive session on a graph: every update re-executes only the
+    // steps affected by what changed since the previous one (see GraphSession).
+    // Returns nullptr if the graph does not exist.
+    std::unique_ptr<GraphSession> openGraphSession(const std::string& graphId);
+
+    // Queues the state of every node that changed since the last checkpoint
+    // (see Checkpointer); with wait, returns once it is on disk. Checkpoints
+    // also run periodically and at shutdown when the "checkpoint" section of
+    // base_config.json enables them. Returns false if they are disabled.
+    bool checkpoint(bool wait = false);
+
+    // Registers a node and interns its ID, or replaces the node registered
+    // under it (same slot, same NodeRef). Safe while messages flow: readers
+    // never lock the node table, the new table or node is published atomically,
+    // and a replaced node keeps serving the calls already running on it until
+    // the EpochReclaimer deletes it after the last one.
     void registerNode(const std::string& nodeId, std::unique_ptr<Node> nodePtr);
 
 private:
     // Private constructor for Singleton pattern
     Linker();
-    // Private destructor for Singleton (default is typically fine)
-    ~Linker() = default;
+    // Private destructor for Singleton. Takes a last checkpoint if enabled.
+    ~Linker();
+
+    // Everything the Linker keeps for one registered node. The node and memo
+    // cache are owned; replaced ones go to the EpochReclaimer, so readers
+    // load them inside an EpochReclaimer::ReadScope.
+    struct NodeSlot {
+        ~NodeSlot();
+        std::string id;
+        std::atomic<Node*> node{nullptr};
+        std::unique_ptr<std::recursive_mutex> lock; // Serializes calls to the node
+        std::unique_ptr<NodeActor> actor;           // Actor-mode front end
+        std::atomic<MemoCache*> memo{nullptr};      // Set if the node's outputs are memoized
+        std::atomic<uint64_t> version{0};           // Bumped by every push, for incremental checkpoints
+        std::atomic<uint64_t> configVersion{0};     // Hash of the node's definition; changes when it is replaced
+        uint64_t savedVersion = 0;                  // Version in the last checkpoint
+        // Output of the last hop if the memo cache answered it: the node was not
+        // called, so its own pull() is stale until the next push reaches it.
+        std::atomic<bool> memoServed{false};        // memoOutput is set (checked without the mutex)
+        std::mutex memoOutputMutex;
+        Message memoOutput;
+    };
+
+    // The slot behind a handle, or nullptr if the handle is invalid.
+    NodeSlot* slot(NodeRef ref) const;
+
+    // Hands one input to a node. If the node's memo cache has the input's
+    // output, the node is not called and that output becomes the node's
+    // current output (see memoizedOutput()); otherwise the node is pushed with
+    // its lock held and a successful output is cached. If output is given, it
+    // receives the hop's output (see Node::pullMessage(); shared, not copied, on
+    // a memo hit). Call inside an EpochReclaimer::ReadScope.
+    // Returns the push's result (true on a memo hit).
+    bool deliver(NodeSlot& target, Message message, Message* output);
+    bool deliver(NodeSlot& target, nlohmann::json data, Message* output);
+    // The node's current output if the memo cache answered its last hop, or an
+    // empty Message if the node's own pull() is current.
+    static Message memoizedOutput(NodeSlot& nodeSlot);
+    static void setMemoizedOutput(NodeSlot& nodeSlot, Message output);
+
+    // Takes the slot's lock into lock unless the node handles concurrent calls
+    // itself (see Node::supportsConcurrentPush()), and returns the node to call.
+    // The node returned is the one that was checked, or was loaded under the
+    // lock, so a replacement never runs unlocked. The lock is recursive so a
+    // node may send to itself without deadlocking. Call inside an
+    // EpochReclaimer::ReadScope. With tryOnly, returns nullptr instead of
+    // waiting for a busy node.
+    static Node* lockNode(NodeSlot& nodeSlot, std::unique_lock<std::recursive_mutex>& lock, bool tryOnly = false);
+
+    // Immutable snapshot of the registry. registerNode() publishes a new one
+    // (copy-on-write); readers load it without locking.
+    struct NodeTable {
+        std::vector<NodeSlot*> slots;                   // Indexed by NodeRef::index
+        std::unordered_map<std::string, uint32_t> index; // Interned IDs, for resolve()
+    };
+    std::atomic<const NodeTable*> m_table;
+    // Owns the slots. Slots are never removed, so handles (and slot pointers) stay valid.
+    std::vector<std::unique_ptr<NodeSlot>> m_slots;
+    std::mutex m_registryMutex; // Serializes registerNode()
+
+    // Loads every graph definition from the graphs/ directory.
+    bool loadGraphs();
+    // Creates and registers a node of a built-in type other than "agent"
+    // (the "type" field of a definition in the agents/ directory).
+    bool loadTypedNode(const std::string& type, const nlohmann::json& config, const std::string& filePath);
+    // Applies the optional "queue", "worker" and "memoize" sections of a node definition.
+    bool applyNodeOptions(const std::string& nodeId, const nlohmann::json& config, const std::string& filePath);
+
+    // Graphs loaded by loadGraphs(), keyed by graph ID.
+    std::map<std::string, Graph> m_graphs;
+
+    // Decides, when a step is ready, whether its previous result can stand.
+    // Returns true and fills reused to skip the step; otherwise fills stepInput
+    // with the input to run it on.
+    using StepReuse = std::function<bool(size_t index, nlohmann::json& stepInput, NodeResult& reused)>;
+    // Runs a graph's steps on a run context ("input" plus step outputs), which
+    // it updates. Without reuse every step runs (runGraph()).
+    // onStepDone (optional) is called with every step that ran and succeeded.
+    // onOutputChunk (optional) streams the output step as runGraph() does.
+    using StepDone = std::function<void(size_t index, const NodeResult& result)>;
+    GraphResult runGraphSteps(const Graph& graph, nlohmann::json& context, const StepReuse& reuse,
+                              const StepDone& onStepDone = nullptr, const ChunkCallback& onOutputChunk = nullptr);
+    // Runs one graph step with executeNodeStreaming(). The steps it feeds over
+    // streamed edges run on its chunks meanwhile, one thread each, and their
+    // results (and those of the steps they feed in turn) are folded into fed,
+    // the text of every chunk's result concatenated.
+    NodeResult runStreamedStep(const Graph& graph, size_t index, nlohmann::json input, const nlohmann::json& graphInput,
+                               const ChunkCallback& onOutputChunk, std::map<size_t, NodeResult>& fed, std::mutex& fedMutex);
+    friend class GraphSession;
+
+    // Limits the requests posted from outside that are in flight at once.
+    AdmissionController m_admission;
+
+    // Queues the changed node states; the Checkpointer's periodic capture.
+    void captureCheckpoint();
+    std::mutex m_checkpointMutex; // One capture at a time
+    // Set when checkpoints are enabled. Declared last: its writer thread calls
+    // captureCheckpoint(), so it must stop before anything else goes away.
+    std::unique_ptr<Checkpointer> m_checkpointer;
 
     
     // Register a Node with the Linker. The Linker needs to know about all
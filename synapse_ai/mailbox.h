@@ -0,0 +1,69 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <atomic>
+#include <utility>
+
+// Lock-free multi-producer single-consumer queue (Vyukov's intrusive MPSC design).
+// - push() may be called from any number of threads at once; it is one atomic
+//   exchange plus one store and never blocks.
+// - pop() must only be called by one consumer at a time (the owning actor).
+// - Messages pushed by the same producer are popped in the order they were pushed.
+// T must be default-constructible and movable.
+template <typename T>
+class MpscMailbox {
+public:
+    MpscMailbox() : m_head(&m_stub), m_tail(&m_stub) {}
+
+    ~MpscMailbox() {
+        T discarded;
+        while (pop(discarded)) {
+        }
+        if (m_tail != &m_stub) {
+            delete m_tail;
+        }
+    }
+
+    // Delete copy constructor and assignment operator (cells are linked by address)
+    MpscMailbox(const MpscMailbox&) = delete;
+    MpscMailbox& operator=(const MpscMailbox&) = delete;
+
+    // Appends a message. Safe to call concurrently from any thread.
+    void push(T value) {
+        Cell* cell = new Cell();
+        cell->value = std::move(value);
+        Cell* previous = m_head.exchange(cell, std::memory_order_acq_rel);
+        // Between the exchange and this store the queue is briefly "cut"; the
+        // consumer then sees it as empty until the link is published.
+        previous->next.store(cell, std::memory_order_release);
+    }
+
+    // Removes the oldest message. Returns false if the queue is (momentarily) empty.
+    // Consumer only.
+    bool pop(T& out) {
+        Cell* tail = m_tail;
+        Cell* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+        // next becomes the new stub; its value is moved out and left empty.
+        out = std::move(next->value);
+        m_tail = next;
+        if (tail != &m_stub) {
+            delete tail;
+        }
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<Cell*> next{nullptr};
+        T value;
+    };
+
+    Cell m_stub;                // Initial empty cell
+    std::atomic<Cell*> m_head;  // Last pushed cell (producers)
+    Cell* m_tail;               // Cell before the oldest message (consumer)
+};
+
+#endif // MAILBOX_H
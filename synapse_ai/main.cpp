@@ -8,13 +8,19 @@
 #include "api_communicator.h"
 #include "linker.h" // Include the Linker header
 #include "timer.h"
+#include "worker_host.h"
 
 // Forward declarations of functions used in main
 void enterConversation(bool *conversing, Linker& linker, Timer& timer);
 void enterDevMode();
 nlohmann::json agentGenerate(std::string agentId, std::string message, Linker& linker);
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Started by the WorkerSupervisor to host an out-of-process node
+    if (WorkerHost::isWorkerCommand(argc, argv)) {
+        return WorkerHost::run(argc, argv);
+    }
+
     // --- IMPORTANT: Set your Google Gemini API Key as an environment variable ---
     // On Linux/macOS: export GEMINI_API_KEY="YOUR_API_KEY_HERE"
     // On Windows (Command Prompt): set GEMINI_API_KEY="YOUR_API_KEY_HERE"
@@ -79,12 +85,8 @@ void enterDevMode() {
 
                 // For testing, we directly pull the response from the agent after it has processed
                 // In a production system, the agent would use Linker to send its response to another Node (e.g., a display node).
-                auto it = Linker::getInstance().m_registeredNodes.find("general_assistant");
-                if (it != Linker::getInstance().m_registeredNodes.end()) {
-                    // Access the raw pointer from the unique_ptr
-                    Node* agentNode = it->second.get(); // Corrected: use .get()
-                    nlohmann::json agentResponse = agentNode->pull(); // Get the processed output
-                    std::cout << "Agent Response (via direct pull for test): " << agentResponse.dump(2) << std::endl;
+                if (Message agentResponse = Linker::getInstance().fetch("general_assistant"); agentResponse.useCount() > 0) {
+                    std::cout << "Agent Response (via fetch for test): " << agentResponse.data().dump(2) << std::endl;
                 }
                 break;
             }
@@ -102,10 +104,8 @@ void enterDevMode() {
 
                 // After the stream, the final output would be in the last node's m_data_out.
                 if (success) {
-                    auto it_last = Linker::getInstance().m_registeredNodes.find("api_communicator"); // Check last node in stream
-                    if (it_last != Linker::getInstance().m_registeredNodes.end()) {
-                        Node* lastNode = it_last->second.get(); // Corrected: use .get()
-                        std::cout << "Final Stream Output (from api_communicator): " << lastNode->pull().dump(2) << std::endl;
+                    if (Message lastOutput = Linker::getInstance().fetch("api_communicator"); lastOutput.useCount() > 0) { // Check last node in stream
+                        std::cout << "Final Stream Output (from api_communicator): " << lastOutput.data().dump(2) << std::endl;
                     }
                 }
                 break;
@@ -117,9 +117,12 @@ void enterDevMode() {
                 nlohmann::json multiData = {{"action", "broadcast"}, {"content", userPrompt}};
 
                 std::vector<std::string> recipients = {"general_assistant", "api_communicator"};
-                bool success = Linker::getInstance().sendMulti(recipients, multiData);
-                std::cout << "Multi-send test result: " << (success ? "SUCCESS" : "FAILED") << std::endl;
-                // In a real scenario, you would then check outputs from each recipient separately.
+                GatherResult results = Linker::getInstance().sendDataMulti(recipients, multiData);
+                std::cout << "Multi-send test result: " << (Linker::allSucceeded(results) ? "SUCCESS" : "FAILED") << std::endl;
+                for (const auto& [nodeId, result] : results) {
+                    std::cout << "  " << nodeId << ": " << (result.success ? "SUCCESS" : "FAILED") << std::endl;
+                    std::cout << result.output.dump(2) << std::endl;
+                }
                 break;
             }
             case LoadConfiguration:
@@ -171,14 +174,56 @@ void enterConversation(bool *conversing, Linker& linker, Timer& timer) {
 	
 	timer.start();
 
-	linker.sendData(agent_optimizer, {{"type","user_input"}, {"content", userPrompt}});
-	linker.send(agent_mia, agent_optimizer);
+	// The optimizer -> MIA topology lives in graphs/mia_conversation.json.
+	// Without that graph, wire the chain by hand. Either way MIA's reply is
+	// printed while it is generated; the optimizer -> MIA edge is "full", as
+	// MIA must answer the optimized prompt as a whole, not sentence by sentence.
+	// A user is waiting on this turn: it goes ahead of any batch work.
+	bool replied = false;
+	std::string errorMessage;
+	Schedule interactive{Priority::Interactive};
+	std::cout << "\nMIA: " << std::flush;
+	if (linker.hasGraph("mia_conversation")) {
+	    bool streamed = false;
+	    GraphResult reply = linker.runGraph("mia_conversation", {{"type","user_input"}, {"content", userPrompt}},
+	        [&streamed](const std::string& chunk) { streamed = true; std::cout << chunk << std::flush; }, interactive);
+	    replied = reply.success;
+	    if (replied && !streamed) {
+	        // Answered from the checkpoint journal: nothing was generated to stream
+	        std::cout << reply.output.value("generated_text", "");
+	    } else if (!replied) {
+	        errorMessage = "graph run failed";
+	        for (const auto& [stepId, step] : reply.steps) {
+	            if (!step.success && step.output.is_object()) {
+	                errorMessage = "step '" + stepId + "': " + step.output.value("error_message", "failed");
+	                break;
+	            }
+	        }
+	    }
+	} else {
+	    Schedule::Scope scheduleScope(interactive);
+	    NodeResult reply = linker.sendDataStreamIncremental(
+	        {agent_optimizer, agent_mia},
+	        {{"type","user_input"}, {"content", userPrompt}},
+	        {ChunkGranularity::Full},
+	        [](const std::string& chunk) { std::cout << chunk << std::flush; });
+	    replied = reply.success;
+	    if (!replied) {
+	        errorMessage = reply.output.value("error_message", "unknown error");
+	    }
+	}
+	std::cout << std::endl;
 
 	timer.capture("Synapse Response");
 
-	std::cout << linker.fetch(agent_optimizer)["generated_text"].get<std::string>() << std::endl;
-
-	std::cout << linker.fetch(agent_mia)["generated_text"].get<std::string>() << std::endl;
+	if (!replied) {
+	    std::cerr << "Conversation Error: " << errorMessage << std::endl;
+	}
 	timer.log();
+	// Break the response time down into network setup vs. server generation time
+	if (ApiCommunicator::getInstance().getDebuggingMode()) {
+	    std::cout << "Optimized prompt: " << linker.fetch(agent_optimizer).data().value("generated_text", "") << std::endl;
+	    ApiCommunicator::getInstance().logTransferStats();
+	}
     }
 }
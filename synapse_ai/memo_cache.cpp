@@ -0,0 +1,95 @@
+// memo_cache.cpp
+#include "memo_cache.h"
+#include <functional>
+#include <iostream>
+
+bool MemoConfig::fromJson(const nlohmann::json& config, MemoConfig& memo, bool& enabled) {
+    if (config.is_boolean()) {
+        enabled = config.get<bool>();
+        return true;
+    }
+    if (!config.is_object()) {
+        std::cerr << "MemoCache Error: 'memoize' must be true, false or an object." << std::endl;
+        return false;
+    }
+    try {
+        memo.maxEntries = config.value("max_entries", memo.maxEntries);
+        memo.ttl = std::chrono::seconds(config.value("ttl_seconds", static_cast<long long>(memo.ttl.count())));
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "MemoCache Error: Invalid 'memoize' configuration: " << e.what() << std::endl;
+        return false;
+    }
+    if (memo.maxEntries == 0) {
+        std::cerr << "MemoCache Error: 'max_entries' must be at least 1." << std::endl;
+        return false;
+    }
+    enabled = true;
+    return true;
+}
+
+MemoCache::MemoCache(MemoConfig config, uint64_t configVersion)
+    : m_config(config), m_configVersion(configVersion) {
+}
+
+uint64_t MemoCache::keyOf(const nlohmann::json& input) const {
+    // Hashes the JSON structure directly; nothing is serialized
+    uint64_t hash = std::hash<nlohmann::json>{}(input);
+    // Mix in the config version (boost::hash_combine style)
+    return m_configVersion ^ (hash + 0x9e3779b97f4a7c15ULL + (m_configVersion << 6) + (m_configVersion >> 2));
+}
+
+MemoCache::Output MemoCache::lookup(uint64_t key, const nlohmann::json& input) {
+    Input storedInput;
+    Output output;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (m_config.ttl.count() > 0 && Clock::now() - it->second->stored > m_config.ttl) {
+            m_lru.erase(it->second);
+            m_index.erase(it);
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        // Move to the front: most recently used
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        storedInput = it->second->input;
+        output = it->second->output;
+    }
+
+    // Compared outside the lock; the same shared payload needs no comparison
+    if (storedInput.get() != &input && *storedInput != input) {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr; // Hash collision: another input's output
+    }
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+    return output;
+}
+
+void MemoCache::store(uint64_t key, Input input, nlohmann::json output) {
+    // Built outside the lock. Not allocated const, so a Message that adopts
+    // the output and ends up its only holder may move it out (Message::take()).
+    store(key, std::move(input), Output(std::make_shared<nlohmann::json>(std::move(output))));
+}
+
+void MemoCache::store(uint64_t key, Input input, Output shared) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        // Same input again, or a colliding one: the newer input takes the entry
+        it->second->input = std::move(input);
+        it->second->output = std::move(shared);
+        it->second->stored = Clock::now();
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return;
+    }
+    m_lru.push_front({key, std::move(input), std::move(shared), Clock::now()});
+    m_index.emplace(key, m_lru.begin());
+    if (m_lru.size() > m_config.maxEntries) {
+        m_index.erase(m_lru.back().key);
+        m_lru.pop_back();
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef MEMO_CACHE_H
+#define MEMO_CACHE_H
+
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Limits of a node's memo cache, from the "memoize" section of its JSON:
+// "memoize": {"max_entries": 256, "ttl_seconds": 600}   (or "memoize": true for the defaults)
+struct MemoConfig {
+    size_t maxEntries = 256;              // Least recently used entries are evicted beyond this
+    std::chrono::seconds ttl{0};          // Entries older than this are not reused; 0 = no expiry
+
+    // Reads a "memoize" value. Sets enabled to false for "memoize": false.
+    // Returns false (and logs) if it is malformed.
+    static bool fromJson(const nlohmann::json& config, MemoConfig& memo, bool& enabled);
+};
+
+// Successful outputs of one deterministic node, keyed by the node's config
+// version and a content hash of the input. A hit returns the stored output
+// without calling the node, so the hop costs neither an HTTP request nor the
+// request/response JSON work.
+// - Thread-safe; lookups do not take the node's lock.
+// - Outputs are shared, immutable snapshots that Messages can carry without
+//   copying them (see Message::derive()).
+// - Each entry keeps its input (the shared payload it was computed from), and
+//   a lookup compares it with the caller's input, so inputs whose hashes
+//   collide never get each other's output.
+class MemoCache {
+public:
+    using Input = std::shared_ptr<const nlohmann::json>;
+    using Output = std::shared_ptr<const nlohmann::json>;
+
+    // configVersion identifies the node's configuration (e.g. a hash of its
+    // JSON definition), so entries from another configuration never match.
+    MemoCache(MemoConfig config, uint64_t configVersion);
+
+    // Delete copy constructor and assignment operator (owns a mutex)
+    MemoCache(const MemoCache&) = delete;
+    MemoCache& operator=(const MemoCache&) = delete;
+
+    // The cache key of an input.
+    uint64_t keyOf(const nlohmann::json& input) const;
+
+    // The output stored for input (whose key is key), or nullptr on a miss, an
+    // expired entry or an entry for another input with the same key.
+    Output lookup(uint64_t key, const nlohmann::json& input);
+    // Stores the output for input, evicting the least recently used entry if
+    // full. The input is kept by reference, not copied.
+    void store(uint64_t key, Input input, nlohmann::json output);
+    // Same for an output that is already shared (e.g. a Message's payload):
+    // the entry keeps a reference to it instead of a copy.
+    void store(uint64_t key, Input input, Output output);
+
+    size_t hits() const { return m_hits.load(std::memory_order_relaxed); }
+    size_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        uint64_t key;
+        Input input;
+        Output output;
+        Clock::time_point stored;
+    };
+
+    const MemoConfig m_config;
+    const uint64_t m_configVersion;
+
+    std::mutex m_mutex;
+    std::list<Entry> m_lru; // Most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+
+    std::atomic<size_t> m_hits{0};
+    std::atomic<size_t> m_misses{0};
+};
+
+#endif // MEMO_CACHE_H
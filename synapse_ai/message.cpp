@@ -0,0 +1,47 @@
+// message.cpp
+#include "message.h"
+
+Message::Message(nlohmann::json payload)
+    : m_payload(std::make_shared<nlohmann::json>(std::move(payload))) {
+}
+
+const nlohmann::json& Message::data() const {
+    static const nlohmann::json empty;
+    return m_payload ? *m_payload : empty;
+}
+
+nlohmann::json& Message::mutableData() {
+    if (!m_payload) {
+        m_payload = std::make_shared<nlohmann::json>();
+    } else if (m_payload.use_count() > 1) {
+        // Someone else still reads this payload: write to our own copy
+        m_payload = std::make_shared<nlohmann::json>(*m_payload);
+    }
+    return *m_payload;
+}
+
+nlohmann::json Message::take() {
+    if (!m_payload) {
+        return nlohmann::json();
+    }
+    nlohmann::json payload = m_payload.use_count() == 1 ? std::move(*m_payload) : *m_payload;
+    m_payload.reset();
+    return payload;
+}
+
+Message Message::derive(const std::string& nodeId, nlohmann::json payload) const {
+    return derive(nodeId, std::make_shared<nlohmann::json>(std::move(payload)));
+}
+
+Message Message::derive(const std::string& nodeId, std::shared_ptr<const nlohmann::json> payload) const {
+    Message next;
+    // Never modified while shared (mutableData() clones it), so dropping const is safe
+    next.m_payload = std::const_pointer_cast<nlohmann::json>(std::move(payload));
+    next.origin = nodeId;
+    next.sessionId = sessionId;
+    next.traceId = traceId;
+    next.deadline = deadline;
+    next.priority = priority;
+    next.cancellation = cancellation;
+    return next;
+}
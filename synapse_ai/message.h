@@ -0,0 +1,64 @@
+#ifndef MESSAGE_H
+#define MESSAGE_H
+
+#include "cancellation.h"
+#include "schedule.h"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+
+// A Message is the envelope nodes exchange: an immutable JSON payload shared by
+// reference count, plus lightweight routing metadata.
+// - Copying a Message (e.g. once per fan-out target) only bumps the count; the
+//   payload is never deep-copied just to be delivered.
+// - Readers use data(). A node that wants to change the payload calls
+//   mutableData(), which clones it first if anyone else still holds it
+//   (copy-on-write), so other recipients never see the change.
+class Message {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Message() = default;
+    explicit Message(nlohmann::json payload);
+
+    // The payload (an empty JSON value if there is none). Safe to read from
+    // several threads at once.
+    const nlohmann::json& data() const;
+    // Writable payload; clones it first if it is shared.
+    nlohmann::json& mutableData();
+    // Moves the payload out if this is the only holder, copies it otherwise.
+    // The Message is left empty.
+    nlohmann::json take();
+
+    // Number of holders of this payload (0 if empty).
+    long useCount() const { return m_payload.use_count(); }
+    // The payload itself, shared (nullptr if empty): keeps it alive read-only
+    // beyond the Message, e.g. as a memo cache entry's input.
+    std::shared_ptr<const nlohmann::json> payload() const { return m_payload; }
+
+    // Metadata for the same message as sent on by `nodeId`: keeps session,
+    // trace, priority, deadline and cancellation, replaces the payload and origin.
+    Message derive(const std::string& nodeId, nlohmann::json payload) const;
+    // Same, adopting a shared read-only payload instead of copying it (e.g. a
+    // memoized output). The payload must not have been allocated const.
+    Message derive(const std::string& nodeId, std::shared_ptr<const nlohmann::json> payload) const;
+
+    // True if a deadline is set and has passed.
+    bool expired() const { return hasDeadline() && Clock::now() >= deadline; }
+    bool hasDeadline() const { return deadline != Clock::time_point::max(); }
+    // Priority class and deadline, for the queues the message's work passes through.
+    Schedule schedule() const { return {priority, deadline}; }
+
+    std::string origin;    // Node that produced the message ("" = outside the Linker)
+    std::string sessionId; // Conversation or job the message belongs to
+    std::string traceId;   // Correlates every hop of one request in logs
+    Clock::time_point deadline = Clock::time_point::max(); // Work after this is wasted
+    Priority priority = Priority::Normal; // Interactive work goes ahead of batch work
+    CancellationToken cancellation; // Cancelled once nobody waits for the result any more
+
+private:
+    std::shared_ptr<nlohmann::json> m_payload; // Never modified while shared
+};
+
+#endif // MESSAGE_H
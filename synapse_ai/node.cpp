@@ -1,5 +1,18 @@
 #include "node.h"
 
-nlohmann::json Node::pull() {
+const nlohmann::json& Node::pull() {
 	return m_data_out;
 }
+
+nlohmann::json Node::saveState() const {
+	return {{"in", m_data_in}, {"out", m_data_out}};
+}
+
+bool Node::loadState(const nlohmann::json& state) {
+	if (!state.is_object()) {
+		return false;
+	}
+	m_data_in = state.value("in", nlohmann::json());
+	m_data_out = state.value("out", nlohmann::json());
+	return true;
+}
@@ -1,14 +1,56 @@
 #ifndef NODE_H
 #define NODE_H
 
+#include "message.h"
 #include <nlohmann/json.hpp>
+#include <functional>
+#include <string>
+
+// Receives a piece of a node's output text while it is still being generated.
+using ChunkCallback = std::function<void(const std::string& chunk)>;
 
 class Node {
 public:
     virtual ~Node() = default; // Added virtual destructor for proper polymorphic deletion
     virtual const std::string& getId() const = 0;
+    // Takes its input by value: callers that are done with their data pass it
+    // with std::move and nothing is copied; callers that keep it pay one copy.
     virtual bool push(nlohmann::json data) = 0;
-    virtual nlohmann::json pull() = 0;
+    // Returns the output of the last push() without copying it. The reference is
+    // only valid until the next push(); copy it if it must outlive that.
+    virtual const nlohmann::json& pull() = 0;
+
+    // Message-based push: the payload may be shared with every other recipient of
+    // the same message, so it must not be modified in place (see Message). The
+    // default takes the payload out, which copies it only if it is still shared;
+    // nodes that just read their input override this and never copy it.
+    virtual bool pushMessage(Message message) { return push(message.take()); }
+    // Output of the last push() as a Message. The default copies pull(); nodes
+    // that keep their output in a Message hand it out shared.
+    virtual Message pullMessage() { return Message(pull()); }
+
+    // Whether push()/pull() may be called from several threads at once.
+    // Nodes that keep their input/output in m_data_in/m_data_out are not, so the
+    // Linker serializes concurrent sends to them; stateless wrappers can return true.
+    virtual bool supportsConcurrentPush() const { return false; }
+
+    // Like push(), but reports the output text while it is produced: onChunk is
+    // called with consecutive pieces that add up to the final "generated_text".
+    // Nodes without partial output report the whole text once push() returns.
+    virtual bool pushStreaming(nlohmann::json data, const ChunkCallback& onChunk) {
+        bool success = push(std::move(data));
+        const nlohmann::json& output = pull();
+        if (success && output.contains("generated_text") && output["generated_text"].is_string()) {
+            onChunk(output["generated_text"].get<std::string>());
+        }
+        return success;
+    }
+
+    // The node's state for checkpoints (see Checkpointer). The default saves the
+    // last input and output; nodes that keep more (e.g. history) extend it.
+    virtual nlohmann::json saveState() const;
+    // Restores what saveState() returned. Returns false if the state does not fit.
+    virtual bool loadState(const nlohmann::json& state);
 
 protected:
     std::string m_id;
@@ -16,4 +58,10 @@ protected:
     nlohmann::json m_data_out;
 };
 
+// Outcome of pushing data to one Node and pulling its output.
+struct NodeResult {
+    bool success = false;
+    nlohmann::json output; // The node's pull() after its push() (error details on failure)
+};
+
 #endif
@@ -0,0 +1,22 @@
+#ifndef NODE_REF_H
+#define NODE_REF_H
+
+#include <cstdint>
+
+// Dense handle for a registered Node. Node IDs are interned when the node is
+// registered; Linker::resolve() turns an ID into its NodeRef once, and every
+// call made through the NodeRef indexes the Linker's node table directly,
+// without comparing or hashing strings.
+// A NodeRef stays valid for the Linker's lifetime; registering a node again
+// under the same ID keeps its handle.
+struct NodeRef {
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    uint32_t index = INVALID; // Position in the Linker's node table
+
+    bool valid() const { return index != INVALID; }
+    bool operator==(const NodeRef& other) const { return index == other.index; }
+    bool operator!=(const NodeRef& other) const { return index != other.index; }
+};
+
+#endif // NODE_REF_H
@@ -0,0 +1,205 @@
+// predicate.cpp
+#include "predicate.h"
+#include <iostream>
+#include <memory>
+#include <regex>
+#include <vector>
+
+namespace {
+
+using Test = std::function<bool(const nlohmann::json&)>;
+
+// Reads a string or an array of strings
+bool readStrings(const nlohmann::json& spec, std::vector<std::string>& strings) {
+    if (spec.is_string()) {
+        strings.push_back(spec.get<std::string>());
+        return true;
+    }
+    if (!spec.is_array()) {
+        return false;
+    }
+    for (const auto& item : spec) {
+        if (!item.is_string()) {
+            return false;
+        }
+        strings.push_back(item.get<std::string>());
+    }
+    return true;
+}
+
+// Builds the accessor for "field": a JSON pointer if it starts with '/', a key otherwise.
+// Returns nullptr for a missing value.
+std::function<const nlohmann::json*(const nlohmann::json&)> makeAccessor(const std::string& field) {
+    if (!field.empty() && field[0] == '/') {
+        auto pointer = std::make_shared<nlohmann::json::json_pointer>(field);
+        return [pointer](const nlohmann::json& value) -> const nlohmann::json* {
+            return value.contains(*pointer) ? &value.at(*pointer) : nullptr;
+        };
+    }
+    return [field](const nlohmann::json& value) -> const nlohmann::json* {
+        if (!value.is_object()) {
+            return nullptr;
+        }
+        auto it = value.find(field);
+        return it != value.end() ? &*it : nullptr;
+    };
+}
+
+bool compileTest(const nlohmann::json& spec, const std::string& defaultField, Test& test);
+
+bool compileList(const nlohmann::json& spec, const std::string& defaultField, std::vector<Test>& tests) {
+    if (!spec.is_array()) {
+        return false;
+    }
+    for (const auto& item : spec) {
+        Test sub;
+        if (!compileTest(item, defaultField, sub)) {
+            return false;
+        }
+        tests.push_back(std::move(sub));
+    }
+    return true;
+}
+
+bool compileTest(const nlohmann::json& spec, const std::string& defaultField, Test& test) {
+    if (!spec.is_object()) {
+        std::cerr << "Predicate Error: A predicate must be an object, got " << spec.dump() << std::endl;
+        return false;
+    }
+
+    auto access = makeAccessor(spec.value("field", defaultField));
+    // Conditions on the field's string value; all must hold
+    std::vector<std::function<bool(const std::string&)>> onText;
+    // Conditions on the field's JSON value or the whole value
+    std::vector<Test> onValue;
+
+    for (const auto& [key, arg] : spec.items()) {
+        if (key == "field") {
+            continue;
+        } else if (key == "min_length" && arg.is_number_unsigned()) {
+            size_t bound = arg.get<size_t>();
+            onText.push_back([bound](const std::string& text) { return text.size() >= bound; });
+        } else if (key == "max_length" && arg.is_number_unsigned()) {
+            size_t bound = arg.get<size_t>();
+            onText.push_back([bound](const std::string& text) { return text.size() <= bound; });
+        } else if (key == "contains" || key == "not_contains") {
+            std::vector<std::string> needles;
+            if (!readStrings(arg, needles)) {
+                std::cerr << "Predicate Error: '" << key << "' needs a string or an array of strings." << std::endl;
+                return false;
+            }
+            const bool wanted = key == "contains";
+            onText.push_back([needles, wanted](const std::string& text) {
+                for (const std::string& needle : needles) {
+                    if ((text.find(needle) != std::string::npos) != wanted) {
+                        return false;
+                    }
+                }
+                return true;
+            });
+        } else if (key == "starts_with" || key == "ends_with") {
+            std::vector<std::string> affixes;
+            if (!readStrings(arg, affixes)) {
+                std::cerr << "Predicate Error: '" << key << "' needs a string or an array of strings." << std::endl;
+                return false;
+            }
+            const bool prefix = key == "starts_with";
+            onText.push_back([affixes, prefix](const std::string& text) {
+                for (const std::string& affix : affixes) {
+                    if (affix.size() <= text.size() &&
+                        text.compare(prefix ? 0 : text.size() - affix.size(), affix.size(), affix) == 0) {
+                        return true;
+                    }
+                }
+                return false;
+            });
+        } else if (key == "regex" && arg.is_string()) {
+            std::shared_ptr<const std::regex> pattern;
+            try {
+                pattern = std::make_shared<const std::regex>(arg.get<std::string>(), std::regex::ECMAScript | std::regex::optimize);
+            } catch (const std::regex_error& e) {
+                std::cerr << "Predicate Error: Invalid regex '" << arg.get<std::string>() << "': " << e.what() << std::endl;
+                return false;
+            }
+            onText.push_back([pattern](const std::string& text) { return std::regex_search(text, *pattern); });
+        } else if (key == "is_json" && arg.is_boolean()) {
+            const bool wanted = arg.get<bool>();
+            onText.push_back([wanted](const std::string& text) {
+                return nlohmann::json::accept(text) == wanted;
+            });
+        } else if (key == "equals") {
+            onValue.push_back([access, arg](const nlohmann::json& value) {
+                const nlohmann::json* field = access(value);
+                return field != nullptr && *field == arg;
+            });
+        } else if (key == "all" || key == "any") {
+            std::vector<Test> tests;
+            if (!compileList(arg, defaultField, tests)) {
+                std::cerr << "Predicate Error: '" << key << "' needs an array of predicates." << std::endl;
+                return false;
+            }
+            const bool all = key == "all";
+            onValue.push_back([tests, all](const nlohmann::json& value) {
+                for (const Test& sub : tests) {
+                    if (sub(value) != all) {
+                        return !all;
+                    }
+                }
+                return all;
+            });
+        } else if (key == "not") {
+            Test sub;
+            if (!compileTest(arg, defaultField, sub)) {
+                return false;
+            }
+            onValue.push_back([sub](const nlohmann::json& value) { return !sub(value); });
+        } else {
+            std::cerr << "Predicate Error: Unknown or invalid condition '" << key << "': " << arg.dump() << std::endl;
+            return false;
+        }
+    }
+
+    test = [access, onText, onValue](const nlohmann::json& value) {
+        if (!onText.empty()) {
+            const nlohmann::json* field = access(value);
+            if (field == nullptr) {
+                return false;
+            }
+            // Non-string values are tested on their serialized form
+            std::string serialized;
+            if (!field->is_string()) {
+                serialized = field->dump();
+            }
+            const std::string& text = field->is_string() ? field->get_ref<const std::string&>() : serialized;
+            for (const auto& condition : onText) {
+                if (!condition(text)) {
+                    return false;
+                }
+            }
+        }
+        for (const Test& condition : onValue) {
+            if (!condition(value)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    return true;
+}
+
+} // namespace
+
+bool Predicate::compile(const nlohmann::json& spec, Predicate& predicate, const std::string& defaultField) {
+    Test test;
+    try {
+        if (!compileTest(spec, defaultField, test)) {
+            return false;
+        }
+    } catch (const nlohmann::json::exception& e) {
+        // e.g. a "field" that is not a valid JSON pointer
+        std::cerr << "Predicate Error: Invalid predicate " << spec.dump() << ": " << e.what() << std::endl;
+        return false;
+    }
+    predicate.m_test = std::move(test);
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef PREDICATE_H
+#define PREDICATE_H
+
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <string>
+
+// A Predicate is a test on a JSON value (typically a node's input or output),
+// compiled once from a JSON spec so that evaluating it does no parsing:
+//
+// {
+//   "field": "generated_text",   // Value tested: a key, or a JSON pointer ("/a/b"); default "generated_text"
+//   "min_length": 1,             // String length bounds
+//   "max_length": 4000,
+//   "contains": ["Answer:"],     // Substrings that must all appear (string or array)
+//   "not_contains": ["I cannot"],// Substrings that must not appear
+//   "starts_with": ["/", "!"],   // Prefix (any of them; string or array)
+//   "ends_with": "?",            // Suffix (any of them; string or array)
+//   "regex": "^\\d+$",           // ECMAScript regex that must match somewhere
+//   "equals": "yes",             // Exact value
+//   "is_json": true,             // The string parses as JSON
+//   "all": [ {...}, ... ],       // Every sub-predicate holds
+//   "any": [ {...}, ... ],       // At least one sub-predicate holds
+//   "not": {...}                 // The sub-predicate does not hold
+// }
+//
+// All conditions in one object must hold. An empty object accepts everything.
+// A missing field fails every condition on it. Sub-predicates use their own
+// "field" (default: the defaultField given to compile()).
+class Predicate {
+public:
+    // The default Predicate accepts everything.
+    Predicate() = default;
+
+    // Compiles a spec. Returns false (and logs) if it is malformed, e.g. an
+    // unknown key or an invalid regex.
+    static bool compile(const nlohmann::json& spec, Predicate& predicate,
+                        const std::string& defaultField = "generated_text");
+
+    bool operator()(const nlohmann::json& value) const { return !m_test || m_test(value); }
+
+private:
+    std::function<bool(const nlohmann::json&)> m_test;
+};
+
+#endif // PREDICATE_H
@@ -0,0 +1,61 @@
+// race_node.cpp
+#include "race_node.h"
+#include "linker.h"
+#include <iostream>
+
+RaceNode::RaceNode(const std::string& id, std::vector<std::string> contestants, Predicate validator)
+    : m_contestants(std::move(contestants)), m_validator(std::move(validator)) {
+    m_id = id;
+}
+
+std::unique_ptr<RaceNode> RaceNode::fromJson(const nlohmann::json& config) {
+    try {
+        std::string id = config.at("id").get<std::string>();
+        std::vector<std::string> contestants = config.at("contestants").get<std::vector<std::string>>();
+        if (contestants.empty()) {
+            std::cerr << "RaceNode Error: Race '" << id << "' has no contestants." << std::endl;
+            return nullptr;
+        }
+        Predicate validator;
+        if (config.contains("validator") && !Predicate::compile(config["validator"], validator)) {
+            std::cerr << "RaceNode Error: Invalid validator in race '" << id << "'." << std::endl;
+            return nullptr;
+        }
+        return std::make_unique<RaceNode>(id, std::move(contestants), std::move(validator));
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "RaceNode Error: Invalid race definition: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+bool RaceNode::push(nlohmann::json data) {
+    return pushMessage(Message(std::move(data)));
+}
+
+bool RaceNode::pushMessage(Message message) {
+    // A race is a first-1 join whose branches must also pass the validator
+    JoinPolicy policy;
+    policy.mode = JoinMode::FirstK;
+    policy.k = 1;
+    policy.cancelStragglers = true;
+    policy.accept = m_validator;
+
+    JoinResult result = Linker::getInstance().sendMessageJoin(m_contestants, std::move(message), policy,
+        [](const std::vector<JoinBranch>& winners) {
+            if (winners.empty()) {
+                return nlohmann::json::object();
+            }
+            nlohmann::json output = winners.front().result.output;
+            output["winner"] = winners.front().nodeId;
+            return output;
+        });
+
+    if (!result.success && !result.branches.empty()) {
+        // Nobody qualified: report the last rejection, which says why
+        m_data_out = result.branches.back().result.output;
+        m_data_out["success"] = false;
+        return false;
+    }
+    m_data_out = std::move(result.output);
+    return result.success;
+}
@@ -0,0 +1,43 @@
+#ifndef RACE_NODE_H
+#define RACE_NODE_H
+
+#include "node.h"
+#include "predicate.h"
+#include <nlohmann/json.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A RaceNode sends its input to several agents at once (e.g. one per model or
+// backend) and returns the first answer that passes its validator; the other
+// requests are cancelled. Where tail latency matters more than quota, the
+// slowest model no longer sets the response time.
+// If no answer passes, the race fails with the last rejection.
+// Configured from a JSON file in the agents/ directory:
+//
+// {
+//   "id": "fast_answer",
+//   "type": "race",
+//   "contestants": ["general_assistant", "local_assistant"],
+//   "validator": {"min_length": 1, "not_contains": "I cannot"}  // optional Predicate (see predicate.h)
+// }
+//
+// The output is the winner's output plus {"winner": nodeId}.
+class RaceNode : public Node {
+public:
+    RaceNode(const std::string& id, std::vector<std::string> contestants, Predicate validator);
+
+    // Builds a RaceNode from its JSON definition. Returns nullptr (and logs) if it is invalid.
+    static std::unique_ptr<RaceNode> fromJson(const nlohmann::json& config);
+
+    const std::string& getId() const override { return m_id; }
+    bool push(nlohmann::json data) override;
+    bool pushMessage(Message message) override;
+    const nlohmann::json& pull() override { return m_data_out; }
+
+private:
+    std::vector<std::string> m_contestants;
+    Predicate m_validator;
+};
+
+#endif // RACE_NODE_H
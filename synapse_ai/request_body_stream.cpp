@@ -0,0 +1,175 @@
+// request_body_stream.cpp
+#include "request_body_stream.h"
+#include <iostream>
+#include <cstring> // For std::memcpy
+#include <algorithm> // For std::min
+
+namespace {
+
+// Thrown inside the serializer to unwind it when the consumer has stopped.
+struct SerializationStopped {};
+
+} // namespace
+
+// Output adapter for nlohmann's serializer: collects bytes into a chunk and
+// hands it to the stream every time the chunk is full.
+class RequestBodyStream::ChunkWriter : public nlohmann::detail::output_adapter_protocol<char> {
+public:
+    explicit ChunkWriter(RequestBodyStream& stream) : m_stream(stream) {
+        m_chunk.reserve(m_stream.m_chunkSize);
+    }
+
+    void write_character(char c) override {
+        m_chunk.push_back(c);
+        if (m_chunk.size() >= m_stream.m_chunkSize) {
+            flush();
+        }
+    }
+
+    void write_characters(const char* s, std::size_t length) override {
+        while (length > 0) {
+            size_t room = m_stream.m_chunkSize - m_chunk.size();
+            size_t n = std::min(room, length);
+            m_chunk.append(s, n);
+            s += n;
+            length -= n;
+            if (m_chunk.size() >= m_stream.m_chunkSize) {
+                flush();
+            }
+        }
+    }
+
+    // Hands the current chunk over and starts a new one
+    void flush() {
+        if (m_chunk.empty()) {
+            return;
+        }
+        if (!m_stream.pushChunk(std::move(m_chunk))) {
+            throw SerializationStopped();
+        }
+        m_chunk = std::string();
+        m_chunk.reserve(m_stream.m_chunkSize);
+    }
+
+private:
+    RequestBodyStream& m_stream;
+    std::string m_chunk;
+};
+
+RequestBodyStream::RequestBodyStream(const nlohmann::json& body, size_t chunkSize, size_t maxBufferedChunks)
+    : m_body(body),
+      m_chunkSize(std::max<size_t>(1, chunkSize)),
+      m_maxBufferedChunks(std::max<size_t>(1, maxBufferedChunks)) {
+}
+
+RequestBodyStream::~RequestBodyStream() {
+    stop();
+}
+
+// Restarts serialization from the first byte
+void RequestBodyStream::start() {
+    stop();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_chunks.clear();
+    m_current.clear();
+    m_currentOffset = 0;
+    m_finished = false;
+    m_failed = false;
+    m_stopped = false;
+    m_producer = std::thread(&RequestBodyStream::produce, this);
+}
+
+// Stops the producer and waits for it to exit
+void RequestBodyStream::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_canPush.notify_all();
+    if (m_producer.joinable()) {
+        m_producer.join();
+    }
+}
+
+void RequestBodyStream::attach(CURL* curl) {
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_READFUNCTION, ReadCallback);
+    curl_easy_setopt(curl, CURLOPT_READDATA, this);
+    curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, SeekCallback);
+    curl_easy_setopt(curl, CURLOPT_SEEKDATA, this);
+    // No POSTFIELDSIZE: the length is unknown until serialization ends,
+    // so libcurl sends the body with chunked transfer encoding.
+}
+
+bool RequestBodyStream::failed() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failed;
+}
+
+void RequestBodyStream::produce() {
+    auto writer = std::make_shared<ChunkWriter>(*this);
+    bool failed = false;
+    try {
+        nlohmann::detail::serializer<nlohmann::json> serializer(writer, ' ');
+        serializer.dump(m_body, false, false, 0);
+        writer->flush();
+    } catch (const SerializationStopped&) {
+        // The transfer was aborted or restarted; nothing more to do.
+    } catch (const std::exception& e) {
+        // E.g. invalid UTF-8 in a string (type_error 316)
+        std::cerr << "RequestBodyStream Error: Failed to serialize request body: " << e.what() << std::endl;
+        failed = true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finished = true;
+    m_failed = failed;
+    m_canRead.notify_all();
+}
+
+bool RequestBodyStream::pushChunk(std::string&& chunk) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_canPush.wait(lock, [this] { return m_stopped || m_chunks.size() < m_maxBufferedChunks; });
+    if (m_stopped) {
+        return false;
+    }
+    m_chunks.push_back(std::move(chunk));
+    m_canRead.notify_one();
+    return true;
+}
+
+size_t RequestBodyStream::read(char* buffer, size_t maxBytes) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_currentOffset >= m_current.size()) {
+        // Current chunk fully sent: wait for the next one (or the end of the body)
+        m_canRead.wait(lock, [this] { return !m_chunks.empty() || m_finished; });
+        if (m_failed) {
+            // Ending the body here would send truncated JSON as if it were complete
+            return CURL_READFUNC_ABORT;
+        }
+        if (m_chunks.empty()) {
+            return 0; // End of body
+        }
+        m_current = std::move(m_chunks.front());
+        m_chunks.pop_front();
+        m_currentOffset = 0;
+        m_canPush.notify_one();
+    }
+
+    size_t n = std::min(maxBytes, m_current.size() - m_currentOffset);
+    std::memcpy(buffer, m_current.data() + m_currentOffset, n);
+    m_currentOffset += n;
+    return n;
+}
+
+size_t RequestBodyStream::ReadCallback(char* buffer, size_t size, size_t nitems, void* userp) {
+    return static_cast<RequestBodyStream*>(userp)->read(buffer, size * nitems);
+}
+
+int RequestBodyStream::SeekCallback(void* userp, curl_off_t offset, int origin) {
+    if (offset != 0 || origin != SEEK_SET) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    static_cast<RequestBodyStream*>(userp)->start();
+    return CURL_SEEKFUNC_OK;
+}
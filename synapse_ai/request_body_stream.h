@@ -0,0 +1,75 @@
+#ifndef REQUEST_BODY_STREAM_H
+#define REQUEST_BODY_STREAM_H
+
+#include <curl/curl.h> // For curl_off_t and the read/seek callback signatures
+#include <nlohmann/json.hpp>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// RequestBodyStream uploads a JSON request body without ever holding its full
+// serialized form in memory:
+// - A producer thread serializes the body straight into fixed-size chunks.
+// - cURL pulls those chunks through ReadCallback() while serialization is still
+//   running, so sending starts as soon as the first chunk is ready.
+// - At most maxBufferedChunks chunks are queued; the serializer waits when the
+//   queue is full, which bounds peak memory regardless of the body size.
+// The JSON passed to the constructor must outlive the stream.
+class RequestBodyStream {
+public:
+    RequestBodyStream(const nlohmann::json& body, size_t chunkSize, size_t maxBufferedChunks);
+    ~RequestBodyStream();
+
+    // Delete copy constructor and assignment operator (owns a thread)
+    RequestBodyStream(const RequestBodyStream&) = delete;
+    RequestBodyStream& operator=(const RequestBodyStream&) = delete;
+
+    // Starts (or restarts) serializing the body from the beginning.
+    // Must be called before each transfer that reads from this stream.
+    void start();
+
+    // Configures an easy handle to POST this stream using chunked transfer encoding.
+    void attach(CURL* curl);
+
+    // True if the body could not be serialized; the transfer was then aborted
+    // (CURLE_ABORTED_BY_CALLBACK) instead of sending a truncated body.
+    bool failed();
+
+    // cURL callback (CURLOPT_READFUNCTION): copies the next serialized bytes into buffer.
+    static size_t ReadCallback(char* buffer, size_t size, size_t nitems, void* userp);
+    // cURL callback (CURLOPT_SEEKFUNCTION): only rewinding to the start is supported.
+    static int SeekCallback(void* userp, curl_off_t offset, int origin);
+
+private:
+    class ChunkWriter; // nlohmann output adapter that fills chunks
+
+    // Producer thread body: serializes m_body into the chunk queue.
+    void produce();
+    // Hands a filled chunk to the consumer. Returns false if the stream was stopped.
+    bool pushChunk(std::string&& chunk);
+    // Copies up to maxBytes into buffer, waiting for the producer if needed.
+    // Returns CURL_READFUNC_ABORT if serialization failed.
+    size_t read(char* buffer, size_t maxBytes);
+    // Stops the producer (if running) and discards any queued data.
+    void stop();
+
+    const nlohmann::json& m_body;
+    const size_t m_chunkSize;
+    const size_t m_maxBufferedChunks;
+
+    std::deque<std::string> m_chunks; // Serialized chunks waiting to be sent
+    std::string m_current;            // Chunk currently being handed to cURL
+    size_t m_currentOffset = 0;       // Bytes of m_current already handed out
+    bool m_finished = false;          // Producer has written the last chunk
+    bool m_failed = false;            // Serialization threw; the body is incomplete
+    bool m_stopped = false;           // Consumer gave up; producer must exit
+
+    std::mutex m_mutex;
+    std::condition_variable m_canPush; // Signalled when a chunk was consumed
+    std::condition_variable m_canRead; // Signalled when a chunk was produced
+    std::thread m_producer;
+};
+
+#endif // REQUEST_BODY_STREAM_H
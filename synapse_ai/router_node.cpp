@@ -0,0 +1,103 @@
+// router_node.cpp
+#include "router_node.h"
+#include "linker.h"
+#include <iostream>
+
+RouterNode::RouterNode(const std::string& id, std::vector<RouteRule> rules, std::string defaultTarget)
+    : m_rules(std::move(rules)), m_defaultTarget(std::move(defaultTarget)) {
+    m_id = id;
+}
+
+std::unique_ptr<RouterNode> RouterNode::fromJson(const nlohmann::json& config) {
+    try {
+        std::string id = config.at("id").get<std::string>();
+        std::string field = config.value("field", "content");
+        std::vector<RouteRule> rules;
+        for (const auto& route : config.value("routes", nlohmann::json::array())) {
+            RouteRule rule;
+            rule.target = route.at("to").get<std::string>();
+            if (!Predicate::compile(route.value("when", nlohmann::json::object()), rule.when, field)) {
+                std::cerr << "RouterNode Error: Invalid condition for route to '" << rule.target
+                          << "' in router '" << id << "'." << std::endl;
+                return nullptr;
+            }
+            rules.push_back(std::move(rule));
+        }
+        std::string defaultTarget = config.value("default", "");
+        if (rules.empty() && defaultTarget.empty()) {
+            std::cerr << "RouterNode Error: Router '" << id << "' has neither routes nor a default." << std::endl;
+            return nullptr;
+        }
+        return std::make_unique<RouterNode>(id, std::move(rules), std::move(defaultTarget));
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "RouterNode Error: Invalid router definition: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+size_t RouterNode::select(const nlohmann::json& data) const {
+    for (size_t i = 0; i < m_rules.size(); ++i) {
+        if (m_rules[i].when(data)) {
+            return i;
+        }
+    }
+    return m_defaultTarget.empty() ? NONE : m_rules.size();
+}
+
+const std::string& RouterNode::route(const nlohmann::json& data) const {
+    static const std::string none;
+    size_t index = select(data);
+    if (index == NONE) {
+        return none;
+    }
+    return index < m_rules.size() ? m_rules[index].target : m_defaultTarget;
+}
+
+bool RouterNode::bindTargets() {
+    Linker& linker = Linker::getInstance();
+    std::vector<NodeRef> targets;
+    for (const RouteRule& rule : m_rules) {
+        targets.push_back(linker.resolve(rule.target));
+    }
+    if (!m_defaultTarget.empty()) {
+        targets.push_back(linker.resolve(m_defaultTarget));
+    }
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (!targets[i].valid()) {
+            const std::string& target = i < m_rules.size() ? m_rules[i].target : m_defaultTarget;
+            std::cerr << "RouterNode Error: Router '" << m_id << "' routes to unknown node '" << target << "'." << std::endl;
+            return false;
+        }
+    }
+    m_targets = std::move(targets);
+    m_bound = true;
+    return true;
+}
+
+bool RouterNode::push(nlohmann::json data) {
+    return pushMessage(Message(std::move(data)));
+}
+
+bool RouterNode::pushMessage(Message message) {
+    if (!m_bound && !bindTargets()) {
+        m_data_out = {{"success", false}, {"error_message", "Router '" + m_id + "' has an unknown target."}};
+        return false;
+    }
+
+    size_t index = select(message.data());
+    if (index == NONE) {
+        std::cerr << "RouterNode Error: No route in '" << m_id << "' accepts the message." << std::endl;
+        m_data_out = {{"success", false}, {"error_message", "No route in '" + m_id + "' accepts the message."}};
+        return false;
+    }
+
+    // The message is handed on as is; the target shares its payload
+    Linker& linker = Linker::getInstance();
+    NodeRef target = m_targets[index];
+    NodeResult result = linker.executeNode(target, std::move(message));
+    m_data_out = std::move(result.output);
+    if (m_data_out.is_object()) {
+        m_data_out["routed_to"] = linker.getNodeId(target);
+    }
+    return result.success;
+}
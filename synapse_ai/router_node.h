@@ -0,0 +1,69 @@
+#ifndef ROUTER_NODE_H
+#define ROUTER_NODE_H
+
+#include "node.h"
+#include "node_ref.h"
+#include "predicate.h"
+#include <nlohmann/json.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// One rule of a RouterNode: messages that satisfy `when` go to `target`.
+struct RouteRule {
+    Predicate when;
+    std::string target;
+};
+
+// A RouterNode sends each message to one of several nodes, chosen by rules
+// that are compiled once when the node is loaded. Cheap inputs (commands,
+// greetings, short questions) can skip an expensive agent entirely, and
+// deciding costs a few predicate evaluations rather than a classification call.
+// Configured from a JSON file in the agents/ directory:
+//
+// {
+//   "id": "front_door",
+//   "type": "router",
+//   "field": "content",          // Field the rules test unless they name their own; default "content"
+//   "routes": [
+//     {"when": {"starts_with": "/"}, "to": "command_handler"},
+//     {"when": {"max_length": 40}, "to": "local_assistant"},
+//     {"when": {"field": "/meta/lang", "equals": "de"}, "to": "german_assistant"}
+//   ],
+//   "default": "general_assistant" // optional
+// }
+//
+// `when` is a Predicate (see predicate.h). The first rule that holds wins; a
+// message no rule accepts goes to "default", or fails if there is none.
+// The message is forwarded as is: its payload is shared, not copied.
+// The output is the target's output plus {"routed_to": nodeId}.
+class RouterNode : public Node {
+public:
+    RouterNode(const std::string& id, std::vector<RouteRule> rules, std::string defaultTarget);
+
+    // Builds a RouterNode from its JSON definition. Returns nullptr (and logs) if it is invalid.
+    static std::unique_ptr<RouterNode> fromJson(const nlohmann::json& config);
+
+    const std::string& getId() const override { return m_id; }
+    bool push(nlohmann::json data) override;
+    bool pushMessage(Message message) override;
+    const nlohmann::json& pull() override { return m_data_out; }
+
+    // The target a payload is routed to ("" if no rule holds and there is no default).
+    const std::string& route(const nlohmann::json& data) const;
+
+private:
+    // Index into m_targets of the first rule that holds, the default's index
+    // (m_rules.size()) or NONE.
+    static constexpr size_t NONE = static_cast<size_t>(-1);
+    size_t select(const nlohmann::json& data) const;
+    // Resolves the targets once, at the first message (they may be loaded after the router).
+    bool bindTargets();
+
+    std::vector<RouteRule> m_rules;
+    std::string m_defaultTarget;
+    std::vector<NodeRef> m_targets; // m_rules[i].target, then the default
+    bool m_bound = false;
+};
+
+#endif // ROUTER_NODE_H
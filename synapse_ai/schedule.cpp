@@ -0,0 +1,65 @@
+// schedule.cpp
+#include "schedule.h"
+#include <atomic>
+
+namespace {
+// Schedule of the innermost active Scope on this thread
+thread_local Schedule t_currentSchedule;
+std::atomic<long long> agingMs{1000};
+}
+
+bool parsePriority(const std::string& name, Priority& priority) {
+    if (name == "interactive") {
+        priority = Priority::Interactive;
+    } else if (name == "normal") {
+        priority = Priority::Normal;
+    } else if (name == "batch") {
+        priority = Priority::Batch;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* priorityName(Priority priority) {
+    switch (priority) {
+    case Priority::Interactive:
+        return "interactive";
+    case Priority::Batch:
+        return "batch";
+    default:
+        return "normal";
+    }
+}
+
+Schedule Schedule::current() {
+    return t_currentSchedule;
+}
+
+void Schedule::setAging(std::chrono::milliseconds aging) {
+    agingMs.store(aging.count() > 0 ? aging.count() : 0, std::memory_order_relaxed);
+}
+
+std::chrono::milliseconds Schedule::aging() {
+    return std::chrono::milliseconds(agingMs.load(std::memory_order_relaxed));
+}
+
+size_t Schedule::effectiveClass(Clock::time_point enqueued, Clock::time_point now) const {
+    size_t level = static_cast<size_t>(priority);
+    long long period = agingMs.load(std::memory_order_relaxed);
+    if (period <= 0 || level == 0 || now <= enqueued) {
+        return level;
+    }
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(now - enqueued).count();
+    size_t promotions = static_cast<size_t>(waited / period);
+    return promotions >= level ? 0 : level - promotions;
+}
+
+Schedule::Scope::Scope(const Schedule& schedule)
+    : m_previous(t_currentSchedule) {
+    t_currentSchedule = schedule;
+}
+
+Schedule::Scope::~Scope() {
+    t_currentSchedule = m_previous;
+}
@@ -0,0 +1,70 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Priority classes, most urgent first. Interactive user turns and background
+// batch jobs share the Executor and the API quota; the class keeps a busy
+// batch job from queueing ahead of a user waiting for an answer.
+enum class Priority : uint8_t {
+    Interactive = 0,
+    Normal = 1,
+    Batch = 2
+};
+constexpr size_t PRIORITY_CLASSES = 3;
+
+// Parses "interactive" / "normal" / "batch". Returns false for anything else.
+bool parsePriority(const std::string& name, Priority& priority);
+const char* priorityName(Priority priority);
+
+// How urgent a piece of work is: its priority class and its deadline.
+// Queues that hold work for a shared resource (the Executor's injection queue,
+// ApiKeyPool's waiting requests) serve the most urgent class first and, within
+// a class, the earliest deadline first (EDF); work without a deadline comes
+// after work with one, in arrival order.
+// Starvation protection: work that has waited longer than the aging period is
+// promoted one class per period, so a batch job still makes progress when
+// interactive traffic never stops.
+//
+// Like CancellationToken, the schedule travels with the thread: a Scope makes
+// it the current schedule, the Executor hands the submitter's schedule on to
+// every task it submits, and the ApiCommunicator queues its requests under the
+// current one. Linker::executeNode() installs a Message's priority and
+// deadline (set message.priority and message.deadline); post(), ask() and
+// runGraph() take a Schedule argument, the caller's by default; other entry
+// points take the caller's.
+struct Schedule {
+    using Clock = std::chrono::steady_clock;
+
+    Priority priority = Priority::Normal;
+    Clock::time_point deadline = Clock::time_point::max();
+
+    // The schedule installed on this thread (Normal, no deadline, if none is).
+    static Schedule current();
+
+    // Sets the aging period (0 disables promotion). Default: 1 second.
+    static void setAging(std::chrono::milliseconds aging);
+    static std::chrono::milliseconds aging();
+
+    // The class a request of this schedule, queued at enqueued, competes in at
+    // now (its own class, promoted for every aging period it has waited).
+    size_t effectiveClass(Clock::time_point enqueued, Clock::time_point now) const;
+
+    // Installs a schedule as the thread's current one for the scope's lifetime.
+    class Scope;
+};
+
+class Schedule::Scope {
+public:
+    explicit Scope(const Schedule& schedule);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+private:
+    Schedule m_previous;
+};
+
+#endif // SCHEDULE_H
@@ -0,0 +1,209 @@
+// shm_ring.cpp
+#include "shm_ring.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+size_t pageSize() {
+    static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+} // namespace
+
+std::unique_ptr<ShmRing> ShmRing::create(size_t capacity) {
+    const size_t page = pageSize();
+    capacity = ((std::max(capacity, page) + page - 1) / page) * page;
+
+    int memFd = ::memfd_create("synapse_ring", MFD_CLOEXEC);
+    if (memFd < 0) {
+        std::cerr << "ShmRing Error: memfd_create failed: " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    if (::ftruncate(memFd, static_cast<off_t>(page + capacity)) != 0) {
+        std::cerr << "ShmRing Error: Could not size the ring: " << std::strerror(errno) << std::endl;
+        ::close(memFd);
+        return nullptr;
+    }
+    int eventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (eventFd < 0) {
+        std::cerr << "ShmRing Error: eventfd failed: " << std::strerror(errno) << std::endl;
+        ::close(memFd);
+        return nullptr;
+    }
+    Header* header = nullptr;
+    uint8_t* data = nullptr;
+    if (!map(memFd, capacity, header, data)) {
+        ::close(memFd);
+        ::close(eventFd);
+        return nullptr;
+    }
+    header = new (header) Header();
+    header->capacity = capacity;
+    return std::unique_ptr<ShmRing>(new ShmRing(memFd, eventFd, capacity, header, data));
+}
+
+std::unique_ptr<ShmRing> ShmRing::attach(int memFd, int eventFd) {
+    struct stat info;
+    if (::fstat(memFd, &info) != 0 || static_cast<size_t>(info.st_size) <= pageSize()) {
+        std::cerr << "ShmRing Error: Not a ring: descriptor " << memFd << "." << std::endl;
+        ::close(memFd);
+        ::close(eventFd);
+        return nullptr;
+    }
+    size_t capacity = static_cast<size_t>(info.st_size) - pageSize();
+    Header* header = nullptr;
+    uint8_t* data = nullptr;
+    if (!map(memFd, capacity, header, data)) {
+        ::close(memFd);
+        ::close(eventFd);
+        return nullptr;
+    }
+    return std::unique_ptr<ShmRing>(new ShmRing(memFd, eventFd, capacity, header, data));
+}
+
+bool ShmRing::map(int memFd, size_t capacity, Header*& header, uint8_t*& data) {
+    const size_t page = pageSize();
+    void* headerPage = ::mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_SHARED, memFd, 0);
+    if (headerPage == MAP_FAILED) {
+        std::cerr << "ShmRing Error: Could not map the ring header: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // Reserve twice the data size, then map the data area into both halves
+    void* reserved = ::mmap(nullptr, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        std::cerr << "ShmRing Error: Could not reserve the ring mapping: " << std::strerror(errno) << std::endl;
+        ::munmap(headerPage, page);
+        return false;
+    }
+    uint8_t* base = static_cast<uint8_t*>(reserved);
+    for (size_t half = 0; half < 2; ++half) {
+        void* mapped = ::mmap(base + half * capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                              memFd, static_cast<off_t>(page));
+        if (mapped == MAP_FAILED) {
+            std::cerr << "ShmRing Error: Could not map the ring data: " << std::strerror(errno) << std::endl;
+            ::munmap(reserved, 2 * capacity);
+            ::munmap(headerPage, page);
+            return false;
+        }
+    }
+    header = static_cast<Header*>(headerPage);
+    data = base;
+    return true;
+}
+
+ShmRing::ShmRing(int memFd, int eventFd, size_t capacity, Header* header, uint8_t* data)
+    : m_memFd(memFd), m_eventFd(eventFd), m_capacity(capacity), m_header(header), m_data(data) {
+}
+
+ShmRing::~ShmRing() {
+    ::munmap(m_data, 2 * m_capacity);
+    ::munmap(m_header, pageSize());
+    ::close(m_memFd);
+    ::close(m_eventFd);
+}
+
+bool ShmRing::write(std::initializer_list<std::reference_wrapper<const nlohmann::json>> records) {
+    const uint64_t head = m_header->head.load(std::memory_order_relaxed); // Only this side writes it
+    const uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+    uint8_t* const start = m_data + head % m_capacity;
+    uint8_t* const end = start + (m_capacity - (head - tail));
+
+    // Encode each record into the reused buffer (public nlohmann API), then
+    // copy it after its length prefix; the mirrored mapping makes the free
+    // space contiguous even across the wrap
+    uint8_t* position = start;
+    for (const nlohmann::json& record : records) {
+        m_encoded.clear(); // Keeps its capacity, so steady-state writes do not allocate
+        nlohmann::json::to_cbor(record, m_encoded);
+        if (static_cast<size_t>(end - position) < 4 + m_encoded.size()) {
+            return false;
+        }
+        uint32_t length = static_cast<uint32_t>(m_encoded.size());
+        std::memcpy(position, &length, sizeof(length));
+        std::memcpy(position + 4, m_encoded.data(), m_encoded.size());
+        position += 4 + m_encoded.size();
+    }
+
+    // Publish, then wake the consumer only if it is going to sleep. Both sides
+    // use sequentially consistent operations here, so either the consumer sees
+    // the new head or this side sees it asleep.
+    m_header->head.store(head + static_cast<uint64_t>(position - start), std::memory_order_seq_cst);
+    if (m_header->consumerAsleep.load(std::memory_order_seq_cst) != 0) {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(m_eventFd, &one, sizeof(one));
+        (void)ignored; // Already signalled if the counter is full
+    }
+    return true;
+}
+
+bool ShmRing::read(nlohmann::json& record) {
+    const uint64_t tail = m_header->tail.load(std::memory_order_relaxed); // Only this side writes it
+    const uint64_t head = m_header->head.load(std::memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+    const uint8_t* position = m_data + tail % m_capacity;
+    uint32_t length = 0;
+    std::memcpy(&length, position, sizeof(length));
+    bool ok = true;
+    if (length > head - tail - 4) {
+        std::cerr << "ShmRing Error: Corrupt record length " << length << "." << std::endl;
+        length = static_cast<uint32_t>(head - tail - 4); // Skip everything written so far
+        ok = false;
+    } else {
+        try {
+            record = nlohmann::json::from_cbor(position + 4, position + 4 + length);
+        } catch (const nlohmann::json::exception& e) {
+            std::cerr << "ShmRing Error: Malformed record: " << e.what() << std::endl;
+            ok = false;
+        }
+    }
+    // Decoded into record, so the space can be reused
+    m_header->tail.store(tail + 4 + length, std::memory_order_release);
+    return ok;
+}
+
+bool ShmRing::readable() const {
+    return m_header->head.load(std::memory_order_acquire) != m_header->tail.load(std::memory_order_relaxed);
+}
+
+bool ShmRing::spinUntilReadable(std::chrono::microseconds spin) const {
+    // On a single core the producer cannot run while this side spins
+    static const bool multicore = std::thread::hardware_concurrency() > 1;
+    if (!multicore) {
+        return readable();
+    }
+    const auto until = std::chrono::steady_clock::now() + spin;
+    while (!readable()) {
+        if (std::chrono::steady_clock::now() >= until) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ShmRing::prepareWait() {
+    m_header->consumerAsleep.store(1, std::memory_order_seq_cst);
+    if (m_header->head.load(std::memory_order_seq_cst) != m_header->tail.load(std::memory_order_relaxed)) {
+        m_header->consumerAsleep.store(0, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void ShmRing::finishWait() {
+    m_header->consumerAsleep.store(0, std::memory_order_relaxed);
+    uint64_t count;
+    ssize_t ignored = ::read(m_eventFd, &count, sizeof(count)); // Non-blocking; EAGAIN if not signalled
+    (void)ignored;
+}
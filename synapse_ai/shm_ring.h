@@ -0,0 +1,88 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+// A single-producer/single-consumer ring of JSON records in shared memory, for
+// passing messages between two processes on the same host without a socket
+// copy or a syscall per byte:
+// - The ring lives in a memfd, mapped twice back to back ("mirrored"), so a
+//   record that wraps around the end is still contiguous in memory. Records are
+//   CBOR-encoded into a reused buffer, copied into the ring in one piece, and
+//   decoded straight out of it.
+// - Each record is a 4-byte length followed by the CBOR bytes.
+// - The consumer sleeps on an eventfd. The producer only writes to it when
+//   the consumer has announced that it is about to sleep, so a busy consumer
+//   costs the producer no syscall.
+// One process creates the ring and hands its two descriptors (fds()) to the
+// other, which attaches to them.
+class ShmRing {
+public:
+    // Creates a ring with room for about capacity bytes (rounded up to whole
+    // pages). Returns nullptr (and logs) on failure.
+    static std::unique_ptr<ShmRing> create(size_t capacity);
+    // Attaches to a ring created by another process; takes ownership of both
+    // descriptors. Returns nullptr (and logs) on failure.
+    static std::unique_ptr<ShmRing> attach(int memFd, int eventFd);
+
+    ~ShmRing();
+
+    // Delete copy constructor and assignment operator (owns a mapping)
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    // Producer: appends records (published together, so the consumer sees all
+    // or none of them) and wakes the consumer if it sleeps. Returns false,
+    // writing nothing, if they do not fit in the free space.
+    bool write(std::initializer_list<std::reference_wrapper<const nlohmann::json>> records);
+
+    // Consumer: takes the oldest record. Returns false if the ring is empty
+    // (or the record is malformed, which is logged).
+    bool read(nlohmann::json& record);
+    // Consumer: true if a record is waiting.
+    bool readable() const;
+    // Consumer: spins for up to `spin` waiting for a record, which saves the
+    // sleep/wake-up round trip when the producer answers quickly (on machines
+    // with more than one core). Returns readable().
+    bool spinUntilReadable(std::chrono::microseconds spin) const;
+    // Consumer: call before sleeping on eventFd(). Returns false if a record
+    // arrived meanwhile, in which case the consumer must not sleep.
+    bool prepareWait();
+    // Consumer: call after waking up; resets the eventfd.
+    void finishWait();
+
+    // The descriptor the consumer polls for POLLIN.
+    int eventFd() const { return m_eventFd; }
+    int memFd() const { return m_memFd; }
+    size_t capacity() const { return m_capacity; }
+
+private:
+    // Shared between both processes, in the first page of the memfd
+    struct Header {
+        std::atomic<uint64_t> head;          // Bytes ever written (producer)
+        std::atomic<uint64_t> tail;          // Bytes ever read (consumer)
+        std::atomic<uint32_t> consumerAsleep; // Consumer is (about to be) blocked on the eventfd
+        uint64_t capacity;
+    };
+
+    ShmRing(int memFd, int eventFd, size_t capacity, Header* header, uint8_t* data);
+    // Maps the header page and the mirrored data area of memFd.
+    static bool map(int memFd, size_t capacity, Header*& header, uint8_t*& data);
+
+    int m_memFd;
+    int m_eventFd;
+    size_t m_capacity; // Size of the data area; a multiple of the page size
+    Header* m_header;
+    uint8_t* m_data;   // m_capacity bytes, mapped twice in a row
+    std::vector<uint8_t> m_encoded; // Producer: CBOR of the record being written, reused
+};
+
+#endif // SHM_RING_H
@@ -0,0 +1,96 @@
+// stream_chunker.cpp
+#include "stream_chunker.h"
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+bool isSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+} // namespace
+
+bool parseChunkGranularity(const std::string& name, ChunkGranularity& granularity) {
+    if (name == "token") {
+        granularity = ChunkGranularity::Token;
+    } else if (name == "sentence") {
+        granularity = ChunkGranularity::Sentence;
+    } else if (name == "paragraph") {
+        granularity = ChunkGranularity::Paragraph;
+    } else if (name == "full") {
+        granularity = ChunkGranularity::Full;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+StreamChunker::StreamChunker(ChunkGranularity granularity, ChunkCallback emit)
+    : m_granularity(granularity), m_emit(std::move(emit)) {
+}
+
+void StreamChunker::feed(const std::string& text) {
+    if (text.empty()) {
+        return;
+    }
+    if (m_granularity == ChunkGranularity::Token) {
+        m_emit(text);
+        return;
+    }
+
+    m_buffer += text;
+    for (size_t length = completeChunkLength(); length > 0; length = completeChunkLength()) {
+        std::string chunk = m_buffer.substr(0, length);
+        m_buffer.erase(0, length);
+        m_emit(chunk);
+    }
+}
+
+void StreamChunker::finish() {
+    if (!m_buffer.empty()) {
+        std::string rest;
+        rest.swap(m_buffer);
+        m_emit(rest);
+    }
+}
+
+size_t StreamChunker::completeChunkLength() const {
+    if (m_granularity == ChunkGranularity::Sentence) {
+        // A sentence ends at . ! or ?, optionally followed by closing quotes or
+        // brackets, and then whitespace. The whitespace stays with the sentence.
+        for (size_t i = 0; i < m_buffer.size(); ++i) {
+            if (std::strchr(".!?", m_buffer[i]) == nullptr) {
+                continue;
+            }
+            size_t end = i + 1;
+            while (end < m_buffer.size() && std::strchr(".!?\"')]", m_buffer[end]) != nullptr) {
+                ++end;
+            }
+            if (end < m_buffer.size() && isSpace(m_buffer[end])) {
+                while (end < m_buffer.size() && isSpace(m_buffer[end])) {
+                    ++end;
+                }
+                // Wait for the next sentence to start, so the whitespace run is complete
+                if (end < m_buffer.size()) {
+                    return end;
+                }
+                return 0;
+            }
+            i = end - 1;
+        }
+        return 0;
+    }
+    if (m_granularity == ChunkGranularity::Paragraph) {
+        size_t blank = m_buffer.find("\n\n");
+        if (blank == std::string::npos) {
+            return 0;
+        }
+        size_t end = blank + 2;
+        while (end < m_buffer.size() && m_buffer[end] == '\n') {
+            ++end;
+        }
+        return end < m_buffer.size() ? end : 0;
+    }
+    return 0; // Full: only finish() emits
+}
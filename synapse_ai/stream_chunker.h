@@ -0,0 +1,39 @@
+#ifndef STREAM_CHUNKER_H
+#define STREAM_CHUNKER_H
+
+#include "node.h"
+#include <string>
+
+// How much of a streamed text is handed on at once.
+enum class ChunkGranularity {
+    Token,     // Every piece as it arrives from the API
+    Sentence,  // Complete sentences (ending in . ! ? followed by whitespace)
+    Paragraph, // Complete paragraphs (ending in a blank line)
+    Full       // The whole text, once the stream has finished
+};
+
+// Parses "token", "sentence", "paragraph" or "full". Returns false for anything else.
+bool parseChunkGranularity(const std::string& name, ChunkGranularity& granularity);
+
+// Regroups a stream of text pieces into chunks of a given granularity.
+// Chunks keep their trailing whitespace, so concatenating every emitted chunk
+// gives back exactly the text that was fed in.
+class StreamChunker {
+public:
+    StreamChunker(ChunkGranularity granularity, ChunkCallback emit);
+
+    // Adds text; emits every chunk it completes.
+    void feed(const std::string& text);
+    // Emits whatever is left, even if it is not a complete chunk.
+    void finish();
+
+private:
+    // Length of the complete chunk at the start of m_buffer, or 0 if there is none yet.
+    size_t completeChunkLength() const;
+
+    ChunkGranularity m_granularity;
+    ChunkCallback m_emit;
+    std::string m_buffer; // Text fed but not yet emitted
+};
+
+#endif // STREAM_CHUNKER_H
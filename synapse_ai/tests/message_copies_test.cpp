@@ -0,0 +1,363 @@
+// message_copies_test.cpp
+// Counts heap allocations to check that messages travel between nodes without
+// deep copies: a replacement operator new records every allocation of exactly
+// the size of the test payload's text, so each copy of that text shows up as
+// one (buffers that merely grow past it, e.g. an HTTP body, are not counted).
+// Agent and ApiCommunicatorNode talk to a local stand-in for the LLM API whose
+// replies are payload-sized as well.
+#include "linker.h"
+#include "agent.h"
+#include "api_communicator_node.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Size of the payload's text; a copy of it allocates one byte more
+const size_t PAYLOAD_BYTES = 1 << 20;
+
+std::atomic<size_t> largeAllocations{0};
+
+} // namespace
+
+// GCC pairs the replacement operators' malloc/free with new/delete at inlined
+// call sites and reports them as mismatched; here they are the same allocator.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    if (size == PAYLOAD_BYTES + 1) {
+        largeAllocations.fetch_add(1);
+    }
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+// Keeps its input by move and reports only the input's size, so its output
+// never copies the payload
+class SizeNode : public Node {
+public:
+    explicit SizeNode(const std::string& id) { m_id = id; }
+    const std::string& getId() const override { return m_id; }
+
+    bool push(nlohmann::json data) override {
+        m_data_in = std::move(data);
+        m_data_out = {{"success", true}, {"size", textSize(m_data_in)}};
+        return true;
+    }
+    // Reads the shared payload in place
+    bool pushMessage(Message message) override {
+        m_data_out = {{"success", true}, {"size", textSize(message.data())}};
+        return true;
+    }
+    const nlohmann::json& pull() override { return m_data_out; }
+
+private:
+    static size_t textSize(const nlohmann::json& data) {
+        for (const char* field : {"content", "generated_text"}) {
+            if (data.contains(field)) {
+                return data[field].get_ref<const std::string&>().size();
+            }
+        }
+        return 0;
+    }
+};
+
+// Passes its input message on unchanged (a hop that forwards the payload)
+class RelayNode : public Node {
+public:
+    explicit RelayNode(const std::string& id) { m_id = id; }
+    const std::string& getId() const override { return m_id; }
+
+    bool push(nlohmann::json data) override { return pushMessage(Message(std::move(data))); }
+    bool pushMessage(Message message) override {
+        m_message = std::move(message);
+        return true;
+    }
+    const nlohmann::json& pull() override { return m_message.data(); }
+    Message pullMessage() override { return m_message; }
+
+private:
+    Message m_message;
+};
+
+// Answers every request on a loopback port with the same payload-sized
+// generateContent reply, one request per connection
+class FakeLlmServer {
+public:
+    bool start() {
+        m_socket = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (m_socket < 0 || bind(m_socket, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+            listen(m_socket, 8) != 0 || getsockname(m_socket, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            return false;
+        }
+        m_port = ntohs(address.sin_port);
+
+        // Built once up front, so serving a request allocates nothing counted
+        nlohmann::json reply;
+        reply["candidates"][0]["content"]["parts"][0]["text"] = std::string(PAYLOAD_BYTES, 'y');
+        std::string body = reply.dump();
+        m_response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                     std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        std::thread(&FakeLlmServer::serve, this).detach();
+        return true;
+    }
+    int port() const { return m_port; }
+
+private:
+    void serve() {
+        for (;;) {
+            int connection = accept(m_socket, nullptr, nullptr);
+            if (connection < 0) {
+                continue;
+            }
+            readRequest(connection);
+            size_t sent = 0;
+            while (sent < m_response.size()) {
+                ssize_t n = send(connection, m_response.data() + sent, m_response.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    break;
+                }
+                sent += static_cast<size_t>(n);
+            }
+            close(connection);
+        }
+    }
+
+    // Reads the headers into a fixed buffer, then discards Content-Length body bytes
+    static void readRequest(int connection) {
+        char buffer[65536];
+        size_t used = 0;
+        const char* headerEnd = nullptr;
+        while (headerEnd == nullptr && used < sizeof(buffer) - 1) {
+            ssize_t n = recv(connection, buffer + used, sizeof(buffer) - 1 - used, 0);
+            if (n <= 0) {
+                return;
+            }
+            used += static_cast<size_t>(n);
+            buffer[used] = '\0';
+            headerEnd = std::strstr(buffer, "\r\n\r\n");
+        }
+        if (headerEnd == nullptr) {
+            return;
+        }
+        size_t bodyBytes = 0;
+        if (const char* field = strcasestr(buffer, "Content-Length:")) {
+            bodyBytes = std::strtoul(field + std::strlen("Content-Length:"), nullptr, 10);
+        }
+        size_t received = used - static_cast<size_t>(headerEnd + 4 - buffer);
+        while (received < bodyBytes) {
+            ssize_t n = recv(connection, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return;
+            }
+            received += static_cast<size_t>(n);
+        }
+    }
+
+    int m_socket = -1;
+    int m_port = 0;
+    std::string m_response;
+};
+
+// Points the ApiCommunicator at the fake server through a base_config.json in
+// a scratch directory
+bool startApi(FakeLlmServer& server) {
+    char directory[] = "/tmp/message_copies_test.XXXXXX";
+    if (!server.start() || mkdtemp(directory) == nullptr || chdir(directory) != 0) {
+        return false;
+    }
+    std::ofstream("base_config.json") << nlohmann::json{
+        {"api_url", "http://127.0.0.1:" + std::to_string(server.port()) + "/"},
+        {"streaming_upload_threshold_bytes", -1}
+    };
+    setenv("GEMINI_API_KEY", "test-key", 1);
+    return ApiCommunicator::getInstance().initialize();
+}
+
+nlohmann::json makePayload() {
+    return {{"content", std::string(PAYLOAD_BYTES, 'x')}};
+}
+
+int failures = 0;
+
+void expect(const char* name, size_t allocations, size_t expected) {
+    bool passed = allocations == expected;
+    std::cout << (passed ? "PASS " : "FAIL ") << name << ": " << allocations
+              << " payload allocation(s), expected " << expected << std::endl;
+    if (!passed) {
+        ++failures;
+    }
+}
+
+// Checks the text size a SizeNode reported in a result
+void expectSize(const char* name, const nlohmann::json& output) {
+    if (output.value("size", static_cast<size_t>(0)) != PAYLOAD_BYTES) {
+        std::cout << "FAIL " << name << ": the node did not see the payload" << std::endl;
+        ++failures;
+    }
+}
+
+// Checks that a fetched output still holds the payload's text
+void expectText(const char* name, const Message& output, const char* field) {
+    const nlohmann::json& data = output.data();
+    if (!data.contains(field) || data[field].get_ref<const std::string&>().size() != PAYLOAD_BYTES) {
+        std::cout << "FAIL " << name << ": wrong output" << std::endl;
+        ++failures;
+    }
+}
+
+} // namespace
+
+int main() {
+    Linker& linker = Linker::getInstance();
+    linker.registerNode("size_a", std::make_unique<SizeNode>("size_a"));
+    linker.registerNode("size_b", std::make_unique<SizeNode>("size_b"));
+    linker.registerNode("size_c", std::make_unique<SizeNode>("size_c"));
+    linker.registerNode("size_d", std::make_unique<SizeNode>("size_d"));
+    linker.registerNode("relay", std::make_unique<RelayNode>("relay"));
+    linker.registerNode("memo_relay", std::make_unique<RelayNode>("memo_relay"));
+    linker.configureMemo("memo_relay", MemoConfig{}, 1);
+    const NodeRef sizeA = linker.resolve("size_a");
+    const NodeRef relay = linker.resolve("relay");
+    const NodeRef memoRelay = linker.resolve("memo_relay");
+
+    // A moved JSON hop: push() takes the caller's document
+    nlohmann::json payload = makePayload();
+    largeAllocations = 0;
+    linker.sendData(sizeA, std::move(payload));
+    expect("sendData by move", largeAllocations, 0);
+
+    // fetch() shares the output a node keeps in a Message
+    linker.sendData(relay, makePayload());
+    largeAllocations = 0;
+    Message fetched = linker.fetch(relay);
+    expect("fetch", largeAllocations, 0);
+    expectText("fetch", fetched, "content");
+    fetched = Message();
+
+    // A node-to-node hop: the relay's output message goes on shared
+    largeAllocations = 0;
+    linker.send("size_a", "relay");
+    expect("send between nodes", largeAllocations, 0);
+
+    // Fan-out: one payload allocation, however many targets share it
+    largeAllocations = 0;
+    GatherResult results = linker.sendMessageMulti({"size_a", "size_b", "size_c", "size_d"}, Message(makePayload()));
+    expect("sendMessageMulti to 4 nodes", largeAllocations, 1);
+    for (const auto& [nodeId, result] : results) {
+        expectSize("sendMessageMulti", result.output);
+    }
+
+    // The same fan-out from a JSON document, which becomes the shared payload
+    payload = makePayload();
+    largeAllocations = 0;
+    results = linker.sendDataMulti({"size_a", "size_b", "size_c", "size_d"}, std::move(payload));
+    expect("sendDataMulti to 4 nodes", largeAllocations, 0);
+    for (const auto& [nodeId, result] : results) {
+        expectSize("sendDataMulti", result.output);
+    }
+
+    // A chain: each hop's output Message is the next hop's input
+    payload = makePayload();
+    largeAllocations = 0;
+    linker.sendDataStream({"relay", "size_b"}, std::move(payload));
+    expect("sendDataStream through relay", largeAllocations, 0);
+    expectSize("sendDataStream", linker.fetch("size_b").data());
+
+    // executeNode() moves the input in; a result the node keeps as well (the
+    // relay's output) is copied once into the NodeResult
+    payload = makePayload();
+    largeAllocations = 0;
+    NodeResult result = linker.executeNode(sizeA, std::move(payload));
+    expect("executeNode by move", largeAllocations, 0);
+    expectSize("executeNode", result.output);
+    payload = makePayload();
+    largeAllocations = 0;
+    result = linker.executeNode(relay, std::move(payload));
+    expect("executeNode of a node that keeps its output", largeAllocations, 1);
+
+    // The memo cache shares the node's output instead of storing a copy, and a
+    // hit hands the stored output on shared
+    payload = makePayload();
+    largeAllocations = 0;
+    linker.sendData(memoRelay, std::move(payload));
+    expect("memoized hop (miss)", largeAllocations, 0);
+    payload = makePayload();
+    largeAllocations = 0;
+    linker.sendData(memoRelay, std::move(payload));
+    fetched = linker.fetch(memoRelay);
+    expect("memoized hop (hit) and fetch", largeAllocations, 0);
+    expectText("memoized hop", fetched, "content");
+    fetched = Message();
+
+    // ApiCommunicatorNode and Agent, against a local stand-in for the LLM API.
+    // Receiving a reply allocates its text once (parsed out of the HTTP body);
+    // after that it is only shared.
+    FakeLlmServer server;
+    if (!startApi(server)) {
+        std::cout << "FAIL could not start the fake LLM API" << std::endl;
+        return 1;
+    }
+    linker.registerNode("api_communicator", std::make_unique<ApiCommunicatorNode>("api_communicator"));
+    linker.registerNode("agent", std::make_unique<Agent>("agent", "Agent",
+        LLMParameters{"test-model", 0.5f, 0.9f, 1, 16, 1, "", ""}));
+    const NodeRef api = linker.resolve("api_communicator");
+    const NodeRef agent = linker.resolve("agent");
+
+    largeAllocations = 0;
+    linker.sendData(api, {{"content", "hello"}, {"llm_params", {{"model", "test-model"}}}});
+    fetched = linker.fetch(api);
+    expect("ApiCommunicatorNode reply and fetch", largeAllocations, 1);
+    expectText("ApiCommunicatorNode", fetched, "generated_text");
+    fetched = Message();
+
+    largeAllocations = 0;
+    linker.sendData(agent, {{"content", "hello"}});
+    fetched = linker.fetch(agent);
+    expect("Agent reply and fetch", largeAllocations, 1);
+    expectText("Agent", fetched, "generated_text");
+    fetched = Message();
+
+    largeAllocations = 0;
+    linker.send("agent", "size_c");
+    expect("send from Agent", largeAllocations, 0);
+    expectSize("send from Agent", linker.fetch("size_c").data());
+
+    // A payload-sized prompt is copied once into the API request (the Agent
+    // keeps its input message), plus the reply
+    payload = makePayload();
+    largeAllocations = 0;
+    linker.sendData(agent, std::move(payload));
+    expect("Agent with a payload-sized prompt", largeAllocations, 2);
+
+    std::cout << (failures == 0 ? "All message copy tests passed." : "Message copy tests failed.") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// wire.cpp
+#include "wire.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+bool sendAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        // MSG_NOSIGNAL: a dead peer is an error return, not a SIGPIPE
+        ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool recvAll(int fd, uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = ::recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false; // Error, or the peer closed the stream
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+// Upper bound on descriptors passed with one frame
+constexpr size_t MAX_FDS = 8;
+
+// Sends the first bytes of a frame with descriptors attached, then the rest
+bool sendWithFds(int fd, const uint8_t* data, size_t size, const std::vector<int>& fds) {
+    if (fds.empty()) {
+        return sendAll(fd, data, size);
+    }
+    if (fds.size() > MAX_FDS) {
+        std::cerr << "Wire Error: Too many descriptors for one frame." << std::endl;
+        return false;
+    }
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS)] = {};
+    iovec io{const_cast<uint8_t*>(data), size};
+    msghdr message{};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+    std::memcpy(CMSG_DATA(header), fds.data(), sizeof(int) * fds.size());
+
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0) {
+        return false;
+    }
+    return sendAll(fd, data + sent, size - static_cast<size_t>(sent));
+}
+
+// Receives the first bytes of a frame together with any attached descriptors
+bool recvWithFds(int fd, uint8_t* data, size_t size, std::vector<int>& fds) {
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_FDS)] = {};
+    iovec io{data, size};
+    msghdr message{};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = ::recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) {
+        return false;
+    }
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+            size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            const int* received_fds = reinterpret_cast<const int*>(CMSG_DATA(header));
+            fds.insert(fds.end(), received_fds, received_fds + count);
+        }
+    }
+    return recvAll(fd, data + received, size - static_cast<size_t>(received));
+}
+
+} // namespace
+
+bool writeFrame(int fd, const nlohmann::json& frame) {
+    return writeFrame(fd, frame, {});
+}
+
+bool readFrame(int fd, nlohmann::json& frame) {
+    std::vector<int> fds;
+    bool ok = readFrame(fd, frame, fds);
+    for (int unexpected : fds) {
+        ::close(unexpected); // Nobody asked for them
+    }
+    return ok;
+}
+
+bool writeFrame(int fd, const nlohmann::json& frame, const std::vector<int>& fds) {
+    // Reserve the length prefix, append the CBOR after it, then fill the prefix in
+    std::vector<uint8_t> bytes(4);
+    nlohmann::json::to_cbor(frame, bytes);
+    size_t length = bytes.size() - 4;
+    if (length > MAX_FRAME_SIZE) {
+        std::cerr << "Wire Error: Frame of " << length << " bytes exceeds the limit." << std::endl;
+        return false;
+    }
+    bytes[0] = static_cast<uint8_t>(length >> 24);
+    bytes[1] = static_cast<uint8_t>(length >> 16);
+    bytes[2] = static_cast<uint8_t>(length >> 8);
+    bytes[3] = static_cast<uint8_t>(length);
+    return sendWithFds(fd, bytes.data(), bytes.size(), fds);
+}
+
+bool readFrame(int fd, nlohmann::json& frame, std::vector<int>& fds) {
+    uint8_t header[4];
+    if (!recvWithFds(fd, header, sizeof(header), fds)) {
+        return false;
+    }
+    uint32_t length = (static_cast<uint32_t>(header[0]) << 24) | (static_cast<uint32_t>(header[1]) << 16) |
+                      (static_cast<uint32_t>(header[2]) << 8) | static_cast<uint32_t>(header[3]);
+    if (length > MAX_FRAME_SIZE) {
+        std::cerr << "Wire Error: Incoming frame of " << length << " bytes exceeds the limit." << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> bytes(length);
+    if (!recvAll(fd, bytes.data(), length)) {
+        return false;
+    }
+    try {
+        frame = nlohmann::json::from_cbor(bytes);
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "Wire Error: Malformed frame: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,27 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <vector>
+
+// Framing for JSON values sent between processes over a stream socket: each
+// frame is a 4-byte big-endian length followed by that many bytes of CBOR
+// (nlohmann's binary writer/reader), so neither side prints or parses text.
+
+// Frames larger than this are refused on both ends.
+constexpr uint32_t MAX_FRAME_SIZE = 64u * 1024u * 1024u;
+
+// Writes one frame. Returns false if the peer is gone or the frame is too
+// large. Never raises SIGPIPE.
+bool writeFrame(int fd, const nlohmann::json& frame);
+// Reads one frame, blocking until it is complete. Returns false at the end of
+// the stream, on an I/O error or on a malformed frame.
+bool readFrame(int fd, nlohmann::json& frame);
+
+// Same, also passing open descriptors along with the frame (SCM_RIGHTS; Unix
+// sockets only). The receiver owns the descriptors it gets.
+bool writeFrame(int fd, const nlohmann::json& frame, const std::vector<int>& fds);
+bool readFrame(int fd, nlohmann::json& frame, std::vector<int>& fds);
+
+#endif // WIRE_H
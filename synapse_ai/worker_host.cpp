@@ -0,0 +1,159 @@
+// worker_host.cpp
+#include "worker_host.h"
+#include "linker.h"
+#include "executor.h"
+#include "shm_ring.h"
+#include "wire.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <future>
+#include <poll.h>
+#include <unistd.h>
+
+namespace {
+bool workerActive = false;
+// How long the worker spins on an empty request ring before it sleeps
+constexpr std::chrono::microseconds RING_SPIN{50};
+}
+
+bool WorkerHost::isWorkerCommand(int argc, char* argv[]) {
+    return argc >= 3 && std::strcmp(argv[1], WORKER_FLAG) == 0;
+}
+
+bool WorkerHost::active() {
+    return workerActive;
+}
+
+int WorkerHost::run(int argc, char* argv[]) {
+    if (!isWorkerCommand(argc, argv)) {
+        std::cerr << "WorkerHost Error: Usage: " << argv[0] << " " << WORKER_FLAG << " <nodeId>" << std::endl;
+        return 2;
+    }
+    std::string nodeId = argv[2];
+    workerActive = true;
+
+    Linker& linker = Linker::getInstance();
+    if (!linker.initialize()) {
+        std::cerr << "WorkerHost Error: Linker initialization failed in the worker for '" << nodeId << "'." << std::endl;
+        return 1;
+    }
+    NodeRef node = linker.resolve(nodeId);
+    if (!node.valid()) {
+        std::cerr << "WorkerHost Error: No node '" << nodeId << "' to host." << std::endl;
+        return 2;
+    }
+    return serve(node, CHANNEL_FD);
+}
+
+int WorkerHost::serve(NodeRef node, int fd) {
+    Linker& linker = Linker::getInstance();
+    // Requests run on the Executor so that a cancel frame can be read while
+    // one is in progress
+    std::future<void> request;
+    CancellationToken token;
+    // "shm" transport, once the parent has sent the rings
+    std::unique_ptr<ShmRing> requests;
+    std::shared_ptr<ShmRing> replies;
+    int status = 0;
+
+    auto start = [&](const nlohmann::json& header, nlohmann::json payload) {
+        if (request.valid()) {
+            request.wait(); // Already replied; the parent sends one request at a time
+        }
+        Message message(std::move(payload));
+        message.sessionId = header.value("session", "");
+        message.traceId = header.value("trace", "");
+        if (header.contains("deadline_ms")) {
+            message.deadline = Message::Clock::now() + std::chrono::milliseconds(header["deadline_ms"].get<long long>());
+        }
+        if (header.contains("priority")) {
+            parsePriority(header.value("priority", ""), message.priority);
+        }
+        token = CancellationToken::create();
+        message.cancellation = token;
+
+        Schedule::Scope scheduleScope(message.schedule()); // Queues by the parent's priority
+        request = Executor::getInstance().async([&linker, node, fd, replies, message = std::move(message)]() mutable {
+            NodeResult result = linker.executeNode(node, std::move(message));
+            nlohmann::json reply;
+            reply["success"] = result.success;
+            reply["output"] = std::move(result.output);
+            // Replies too large for the ring go through the socket
+            bool sent = (replies != nullptr && replies->write({reply})) || writeFrame(fd, reply);
+            if (!sent) {
+                std::cerr << "WorkerHost Error: Could not send a reply to the parent." << std::endl;
+            }
+        });
+    };
+
+    for (;;) {
+        // Requests in the ring first; then sleep until the ring or the socket has something
+        if (requests != nullptr && requests->spinUntilReadable(RING_SPIN)) {
+            nlohmann::json header;
+            nlohmann::json payload;
+            if (!requests->read(header) || !requests->read(payload)) {
+                break; // Out of step with the parent
+            }
+            start(header, std::move(payload));
+            continue;
+        }
+        if (requests != nullptr && !requests->prepareWait()) {
+            continue;
+        }
+        pollfd events[2] = {{fd, POLLIN, 0}, {requests != nullptr ? requests->eventFd() : -1, POLLIN, 0}};
+        int ready = ::poll(events, requests != nullptr ? 2 : 1, -1);
+        if (requests != nullptr) {
+            requests->finishWait();
+            if (requests->readable()) {
+                continue;
+            }
+        }
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "WorkerHost Error: poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (ready <= 0 || events[0].revents == 0) {
+            continue;
+        }
+
+        nlohmann::json header;
+        std::vector<int> fds;
+        if (!readFrame(fd, header, fds)) {
+            break; // The parent closed the connection
+        }
+        std::string op = header.value("op", "");
+        if (op == "shm" && fds.size() == 4) {
+            requests = ShmRing::attach(fds[0], fds[1]);
+            replies = ShmRing::attach(fds[2], fds[3]);
+            if (requests == nullptr || replies == nullptr) {
+                // The parent would wait on rings nobody reads; exit so it restarts the worker
+                status = 1;
+                break;
+            }
+            continue;
+        }
+        for (int unexpected : fds) {
+            ::close(unexpected);
+        }
+        if (op == "cancel") {
+            token.cancel();
+        } else if (op == "push") {
+            nlohmann::json payload;
+            if (!readFrame(fd, payload)) {
+                break;
+            }
+            start(header, std::move(payload));
+        } else {
+            std::cerr << "WorkerHost Error: Unknown request '" << op << "'." << std::endl;
+            break;
+        }
+    }
+
+    // The parent closed the connection (or broke the protocol): finish up
+    token.cancel();
+    if (request.valid()) {
+        request.wait();
+    }
+    return status;
+}
@@ -0,0 +1,40 @@
+#ifndef WORKER_HOST_H
+#define WORKER_HOST_H
+
+#include "node_ref.h"
+
+// The worker side of an out-of-process node (see WorkerProcess). main() hands
+// over to run() when the program was started as `<exe> --worker <nodeId>`:
+// the worker initializes its own Linker from the same agents/ and graphs/,
+// then serves requests for that one node on the inherited socket until the
+// parent closes it.
+//
+// Protocol (CBOR frames, see wire.h), one request at a time:
+//   parent -> worker: {"op": "push", "session", "trace", "deadline_ms"?, "priority"?}, then the payload
+//                     {"op": "cancel"}            cancels the request being served
+//                     {"op": "shm"} + 4 descriptors  the "shm" transport's rings: requests, replies
+//                                                   (each a memfd and an eventfd; see ShmRing)
+//   worker -> parent: {"success": bool, "output": {...}}
+// With rings, a push (header and payload records) and its reply go through
+// them when they fit; the socket carries everything else.
+class WorkerHost {
+public:
+    // Command-line flag that starts a worker.
+    static constexpr const char* WORKER_FLAG = "--worker";
+    // Descriptor the worker inherits its end of the socket pair on.
+    static constexpr int CHANNEL_FD = 3;
+
+    // True if the command line asks for a worker.
+    static bool isWorkerCommand(int argc, char* argv[]);
+    // Runs this process as a worker. Returns the process exit code.
+    static int run(int argc, char* argv[]);
+
+    // True inside a worker process. Nodes marked "worker" run locally there.
+    static bool active();
+
+private:
+    // Serves requests for node on fd until the stream ends.
+    static int serve(NodeRef node, int fd);
+};
+
+#endif // WORKER_HOST_H
@@ -0,0 +1,438 @@
+// worker_process.cpp
+#include "worker_process.h"
+#include "worker_host.h"
+#include "wire.h"
+#include "executor.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+bool WorkerConfig::fromJson(const nlohmann::json& config, WorkerConfig& worker, bool& enabled) {
+    if (config.is_boolean()) {
+        enabled = config.get<bool>();
+        return true;
+    }
+    if (!config.is_object()) {
+        std::cerr << "WorkerProcess Error: 'worker' must be true, false or an object." << std::endl;
+        return false;
+    }
+    try {
+        worker.maxRestarts = config.value("max_restarts", worker.maxRestarts);
+        worker.restartWindow = std::chrono::seconds(
+            config.value("restart_window_seconds", static_cast<long long>(worker.restartWindow.count())));
+        worker.restartBackoff = std::chrono::milliseconds(
+            config.value("restart_backoff_ms", static_cast<long long>(worker.restartBackoff.count())));
+        worker.transport = config.value("transport", worker.transport);
+        worker.ringBytes = config.value("ring_bytes", worker.ringBytes);
+        worker.callTimeout = std::chrono::milliseconds(
+            config.value("call_timeout_ms", static_cast<long long>(worker.callTimeout.count())));
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "WorkerProcess Error: Invalid 'worker' configuration: " << e.what() << std::endl;
+        return false;
+    }
+    if (worker.transport != "socket" && worker.transport != "shm") {
+        std::cerr << "WorkerProcess Error: Unknown transport '" << worker.transport << "' (use \"socket\" or \"shm\")." << std::endl;
+        return false;
+    }
+    enabled = true;
+    return true;
+}
+
+namespace {
+// How long a side waiting on a ring spins before it sleeps on the eventfd
+constexpr std::chrono::microseconds RING_SPIN{50};
+// How long a cancelled call waits for the worker's reply before giving up on it
+constexpr std::chrono::milliseconds CANCEL_GRACE{1000};
+// How often a call checks whether its caller cancelled it
+constexpr std::chrono::milliseconds CANCEL_POLL{50};
+}
+
+// --- WorkerProcess ---
+
+WorkerProcess::WorkerProcess(std::string nodeId, WorkerConfig config)
+    : m_nodeId(std::move(nodeId)), m_config(config) {
+}
+
+WorkerProcess::~WorkerProcess() {
+    stop();
+}
+
+bool WorkerProcess::start() {
+    std::lock_guard<std::mutex> callLock(m_callMutex);
+    return spawn();
+}
+
+// Forks and execs this executable as a worker
+bool WorkerProcess::spawn() {
+    char exe[PATH_MAX];
+    ssize_t length = ::readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (length < 0) {
+        std::cerr << "WorkerProcess Error: Cannot locate the executable to start a worker for '" << m_nodeId << "'." << std::endl;
+        return false;
+    }
+    exe[length] = '\0';
+
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+        std::cerr << "WorkerProcess Error: socketpair failed for '" << m_nodeId << "': " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int devNull = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+    // Everything the child needs is prepared before fork(): between fork() and
+    // exec() a multithreaded process may only make async-signal-safe calls
+    std::string workerFlag = WorkerHost::WORKER_FLAG;
+    std::string nodeId = m_nodeId;
+    char* argv[] = {exe, &workerFlag[0], &nodeId[0], nullptr};
+
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        if (devNull >= 0) {
+            ::dup2(devNull, STDOUT_FILENO); // The parent owns the console; errors still reach stderr
+        }
+        if (fds[1] == WorkerHost::CHANNEL_FD) {
+            ::fcntl(fds[1], F_SETFD, 0); // Keep it across exec
+        } else {
+            ::dup2(fds[1], WorkerHost::CHANNEL_FD); // The duplicate is not close-on-exec
+        }
+        ::execv(exe, argv);
+        ::_exit(127);
+    }
+
+    ::close(fds[1]);
+    if (devNull >= 0) {
+        ::close(devNull);
+    }
+    if (pid < 0) {
+        std::cerr << "WorkerProcess Error: fork failed for '" << m_nodeId << "': " << std::strerror(errno) << std::endl;
+        ::close(fds[0]);
+        return false;
+    }
+    m_fd = fds[0];
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_pid = pid;
+    }
+    std::cout << "WorkerProcess: Started worker " << pid << " for node '" << m_nodeId << "'." << std::endl;
+    if (m_config.transport == "shm") {
+        openRings();
+    }
+    return true;
+}
+
+void WorkerProcess::openRings() {
+    m_requests.reset();
+    m_replies.reset();
+    std::unique_ptr<ShmRing> requests = ShmRing::create(m_config.ringBytes);
+    std::unique_ptr<ShmRing> replies = ShmRing::create(m_config.ringBytes);
+    if (requests == nullptr || replies == nullptr ||
+        !writeFrame(m_fd, {{"op", "shm"}},
+                    {requests->memFd(), requests->eventFd(), replies->memFd(), replies->eventFd()})) {
+        std::cerr << "WorkerProcess Warning: No shared-memory rings for '" << m_nodeId << "'; using the socket." << std::endl;
+        return;
+    }
+    m_requests = std::move(requests);
+    m_replies = std::move(replies);
+}
+
+void WorkerProcess::stop() {
+    pid_t pid;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_stopped = true;
+        pid = m_pid;
+        m_pid = -1;
+    }
+    if (pid > 0) {
+        // A worker busy with a request would only notice the closed socket
+        // afterwards, so it is terminated; an in-flight call then fails
+        ::kill(pid, SIGTERM);
+        int status = 0;
+        for (int i = 0; i < 200 && ::waitpid(pid, &status, WNOHANG) == 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (::waitpid(pid, &status, WNOHANG) == 0) {
+            ::kill(pid, SIGKILL);
+            ::waitpid(pid, &status, 0);
+        }
+    }
+    std::lock_guard<std::mutex> callLock(m_callMutex);
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_requests.reset();
+    m_replies.reset();
+}
+
+bool WorkerProcess::running() const {
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    return m_pid > 0;
+}
+
+NodeResult WorkerProcess::call(const Message& message) {
+    std::lock_guard<std::mutex> callLock(m_callMutex);
+    NodeResult result;
+    if (m_fd < 0) {
+        result.output = {{"success", false}, {"error_message", "Worker for node '" + m_nodeId + "' is not running."}};
+        return result;
+    }
+
+    // Message metadata, then the payload as a record of its own (encoded
+    // straight from the shared payload, without copying it into the header).
+    // The ring takes them if they fit; otherwise they go through the socket.
+    nlohmann::json header = {{"op", "push"}, {"session", message.sessionId}, {"trace", message.traceId}};
+    if (message.hasDeadline()) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(message.deadline - Message::Clock::now());
+        header["deadline_ms"] = std::max<long long>(0, remaining.count());
+    }
+    if (message.priority != Priority::Normal) {
+        header["priority"] = priorityName(message.priority);
+    }
+    bool queued = m_requests != nullptr && m_requests->write({header, message.data()});
+    if (!queued && (!writeFrame(m_fd, header) || !writeFrame(m_fd, message.data()))) {
+        fail();
+        result.output = {{"success", false}, {"error_message", "Could not reach the worker for node '" + m_nodeId + "'."}};
+        return result;
+    }
+
+    // Wait for the reply; while the caller can still cancel, check for that
+    // every 50 ms and pass a cancellation on to the worker. The deadline or the
+    // call timeout cancels the request too, and the worker gets CANCEL_GRACE to
+    // answer a cancelled request before it counts as hung.
+    CancellationToken token = message.cancellation.cancellable() ? message.cancellation : CancellationToken::current();
+    Executor::BlockingScope blocking; // Like an HTTP call: the pool may add a worker meanwhile
+    Clock::time_point giveUpAt = Clock::time_point::max();
+    if (m_config.callTimeout.count() > 0) {
+        giveUpAt = Clock::now() + m_config.callTimeout;
+    }
+    if (message.hasDeadline()) {
+        giveUpAt = std::min(giveUpAt, message.deadline);
+    }
+    bool cancelSent = false;
+    bool timedOut = false;
+    nlohmann::json reply;
+    bool received = false;
+    for (;;) {
+        // A reply in the ring wins over the socket: a worker that exits right
+        // after replying also makes the socket readable
+        if (m_replies != nullptr && m_replies->spinUntilReadable(RING_SPIN)) {
+            received = m_replies->read(reply);
+            break;
+        }
+        if (m_replies != nullptr && !m_replies->prepareWait()) {
+            continue;
+        }
+        int timeoutMs = -1;
+        if (giveUpAt != Clock::time_point::max()) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(giveUpAt - Clock::now()).count() + 1;
+            timeoutMs = static_cast<int>(std::clamp<long long>(left, 0, std::numeric_limits<int>::max()));
+        }
+        if (token.cancellable() && !cancelSent && (timeoutMs < 0 || timeoutMs > CANCEL_POLL.count())) {
+            timeoutMs = static_cast<int>(CANCEL_POLL.count());
+        }
+        pollfd events[2] = {{m_fd, POLLIN, 0}, {m_replies != nullptr ? m_replies->eventFd() : -1, POLLIN, 0}};
+        int ready = ::poll(events, m_replies != nullptr ? 2 : 1, timeoutMs);
+        if (m_replies != nullptr) {
+            m_replies->finishWait();
+            if (m_replies->readable()) {
+                continue;
+            }
+        }
+        if (ready > 0 && events[0].revents != 0) {
+            received = readFrame(m_fd, reply);
+            break;
+        }
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        const bool expired = Clock::now() >= giveUpAt;
+        if (expired && cancelSent) {
+            timedOut = true; // Not even a cancelled request gets an answer: the worker is hung
+            break;
+        }
+        if (!cancelSent && (expired || token.cancelled())) {
+            cancelSent = true;
+            writeFrame(m_fd, {{"op", "cancel"}});
+            giveUpAt = Clock::now() + CANCEL_GRACE;
+        }
+    }
+
+    if (timedOut) {
+        fail();
+        std::cerr << "WorkerProcess Error: Worker for node '" << m_nodeId << "' did not answer in time; restarting it." << std::endl;
+        result.output = {{"success", false}, {"error_message", "Worker for node '" + m_nodeId + "' timed out."}};
+        return result;
+    }
+    if (!received || !reply.is_object()) {
+        fail();
+        std::cerr << "WorkerProcess Error: Lost the worker for node '" << m_nodeId << "' during a request." << std::endl;
+        result.output = {{"success", false}, {"error_message", "Worker for node '" + m_nodeId + "' exited."}};
+        return result;
+    }
+    result.success = reply.value("success", false);
+    result.output = std::move(reply["output"]);
+    return result;
+}
+
+void WorkerProcess::fail() {
+    ::close(m_fd);
+    m_fd = -1;
+    m_requests.reset();
+    m_replies.reset();
+    // A worker that is still alive is out of step with the protocol; supervise() restarts it
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    if (m_pid > 0) {
+        ::kill(m_pid, SIGKILL);
+    }
+}
+
+void WorkerProcess::supervise() {
+    Clock::time_point now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        if (m_stopped || m_gaveUp) {
+            return;
+        }
+        if (m_pid > 0) {
+            int status = 0;
+            pid_t reaped = ::waitpid(m_pid, &status, WNOHANG);
+            if (reaped == 0) {
+                return; // Still running
+            }
+            std::cerr << "WorkerProcess Warning: Worker " << m_pid << " for node '" << m_nodeId << "' ";
+            if (reaped > 0 && WIFEXITED(status)) {
+                std::cerr << "exited with status " << WEXITSTATUS(status) << "." << std::endl;
+            } else if (reaped > 0 && WIFSIGNALED(status)) {
+                std::cerr << "was killed by signal " << WTERMSIG(status) << "." << std::endl;
+            } else {
+                std::cerr << "is gone." << std::endl;
+            }
+            m_pid = -1;
+            // Back off: each restart within the window doubles the delay
+            while (!m_recentRestarts.empty() && now - m_recentRestarts.front() > m_config.restartWindow) {
+                m_recentRestarts.pop_front();
+            }
+            size_t shift = std::min<size_t>(m_recentRestarts.size(), 6);
+            m_nextStart = now + m_config.restartBackoff * (1 << shift);
+        }
+
+        while (!m_recentRestarts.empty() && now - m_recentRestarts.front() > m_config.restartWindow) {
+            m_recentRestarts.pop_front();
+        }
+        if (m_recentRestarts.size() >= m_config.maxRestarts) {
+            m_gaveUp = true;
+            std::cerr << "WorkerProcess Error: Worker for node '" << m_nodeId << "' failed " << m_recentRestarts.size()
+                      << " times within " << m_config.restartWindow.count() << " s; not restarting it." << std::endl;
+            return;
+        }
+        if (now < m_nextStart) {
+            return;
+        }
+    }
+
+    // A call that is still running will fail on the dead connection and
+    // release the lock; the restart waits until the next round
+    std::unique_lock<std::mutex> callLock(m_callMutex, std::try_to_lock);
+    if (!callLock.owns_lock()) {
+        return;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd); // Connection to the dead worker
+        m_fd = -1;
+    }
+    m_requests.reset();
+    m_replies.reset();
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        if (m_stopped) {
+            return;
+        }
+        m_recentRestarts.push_back(now);
+        m_nextStart = now + m_config.restartBackoff;
+    }
+    m_restarts.fetch_add(1, std::memory_order_relaxed);
+    spawn();
+}
+
+// --- RemoteNode ---
+
+RemoteNode::RemoteNode(std::shared_ptr<WorkerProcess> worker)
+    : m_worker(std::move(worker)) {
+    m_id = m_worker->getNodeId();
+}
+
+bool RemoteNode::push(nlohmann::json data) {
+    return pushMessage(Message(std::move(data)));
+}
+
+bool RemoteNode::pushMessage(Message message) {
+    NodeResult result = m_worker->call(message);
+    m_data_out = std::move(result.output);
+    return result.success;
+}
+
+// --- WorkerSupervisor ---
+
+WorkerSupervisor& WorkerSupervisor::getInstance() {
+    static WorkerSupervisor instance;
+    return instance;
+}
+
+WorkerSupervisor::~WorkerSupervisor() {
+    shutdown();
+}
+
+std::shared_ptr<WorkerProcess> WorkerSupervisor::launch(const std::string& nodeId, const WorkerConfig& config) {
+    auto worker = std::make_shared<WorkerProcess>(nodeId, config);
+    if (!worker->start()) {
+        std::cerr << "WorkerSupervisor Error: Could not start the worker for '" << nodeId << "'; retrying later." << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_workers.push_back(worker);
+    if (!m_watcher.joinable() && !m_stopping) {
+        m_watcher = std::thread(&WorkerSupervisor::watch, this);
+    }
+    return worker;
+}
+
+void WorkerSupervisor::shutdown() {
+    std::vector<std::shared_ptr<WorkerProcess>> workers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        workers = m_workers;
+    }
+    m_wake.notify_all();
+    if (m_watcher.joinable()) {
+        m_watcher.join();
+    }
+    for (auto& worker : workers) {
+        worker->stop();
+    }
+}
+
+void WorkerSupervisor::watch() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        m_wake.wait_for(lock, std::chrono::milliseconds(100));
+        if (m_stopping) {
+            break;
+        }
+        std::vector<std::shared_ptr<WorkerProcess>> workers = m_workers;
+        lock.unlock();
+        for (auto& worker : workers) {
+            worker->supervise();
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,151 @@
+#ifndef WORKER_PROCESS_H
+#define WORKER_PROCESS_H
+
+#include "node.h"
+#include "shm_ring.h"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+// Restart limits of a node hosted in a worker process, from the "worker"
+// section of its JSON:
+// "worker": {"max_restarts": 5, "restart_window_seconds": 60, "restart_backoff_ms": 200,
+//            "transport": "shm", "ring_bytes": 4194304, "call_timeout_ms": 300000}
+// (or "worker": true for the defaults)
+struct WorkerConfig {
+    size_t maxRestarts = 5;                       // Restarts allowed within restartWindow before giving up
+    std::chrono::seconds restartWindow{60};
+    std::chrono::milliseconds restartBackoff{200}; // Delay before a restart; doubles with each recent restart
+    // "socket" sends every message through the socket; "shm" puts requests and
+    // replies in a pair of shared-memory rings (see ShmRing) and keeps the
+    // socket for control, for liveness and for messages too large for a ring.
+    std::string transport = "socket";
+    size_t ringBytes = 4 * 1024 * 1024;           // Size of each ring with "shm"
+    // Longest a call waits for its reply (a message's deadline may shorten it).
+    // Then the request is cancelled, and a worker that still does not answer
+    // is killed and restarted. 0 = wait as long as the deadline allows.
+    std::chrono::milliseconds callTimeout{300000};
+
+    // Reads a "worker" value. Sets enabled to false for "worker": false.
+    // Returns false (and logs) if it is malformed.
+    static bool fromJson(const nlohmann::json& config, WorkerConfig& worker, bool& enabled);
+};
+
+// One worker process hosting one node, as seen from the parent. The worker is
+// this same executable started as `<exe> --worker <nodeId>` (see WorkerHost);
+// it loads the usual agents/ and graphs/ and runs the node locally. The two
+// processes talk over a Unix-domain socket pair with CBOR frames (see wire.h),
+// or through shared-memory rings with the "shm" transport.
+// Calls are serialized: one request is in flight per worker at a time.
+class WorkerProcess {
+public:
+    WorkerProcess(std::string nodeId, WorkerConfig config);
+    ~WorkerProcess();
+
+    // Delete copy constructor and assignment operator (owns a process)
+    WorkerProcess(const WorkerProcess&) = delete;
+    WorkerProcess& operator=(const WorkerProcess&) = delete;
+
+    // Starts the worker. Returns false (and logs) if it could not be started.
+    bool start();
+    // Terminates and reaps the worker (killing it if it does not exit in time)
+    // and closes the connection. A stopped worker is not restarted.
+    void stop();
+
+    // Runs message on the worker's node and waits for its result. Cancelling the
+    // message's token cancels the request in the worker; the message's deadline
+    // is passed on. Fails at once if the worker is down. Once the deadline or
+    // the call timeout passes, the request is cancelled; if the worker does not
+    // reply within a grace period after that, it is treated as hung: the call
+    // fails and the worker is killed, so the supervisor restarts it.
+    NodeResult call(const Message& message);
+
+    // Called periodically by the WorkerSupervisor: reaps the worker if it has
+    // exited and restarts it, within the restart limits.
+    void supervise();
+
+    const std::string& getNodeId() const { return m_nodeId; }
+    bool running() const;
+    size_t restarts() const { return m_restarts.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Starts the worker process; the caller holds m_callMutex.
+    bool spawn();
+    // Creates the rings of the "shm" transport and hands them to the worker.
+    // On failure, calls stay on the socket.
+    void openRings();
+    // Drops the connection after a failed call; supervise() restarts the worker.
+    void fail();
+
+    const std::string m_nodeId;
+    const WorkerConfig m_config;
+
+    std::mutex m_callMutex; // Serializes calls; held while the connection is opened or closed
+    int m_fd = -1;          // Parent end of the socket pair
+    std::unique_ptr<ShmRing> m_requests; // "shm" transport: parent -> worker
+    std::unique_ptr<ShmRing> m_replies;  // "shm" transport: worker -> parent
+
+    mutable std::mutex m_stateMutex;
+    pid_t m_pid = -1;                      // -1 once the worker has been reaped
+    bool m_stopped = false;                // stop() was called: no more restarts
+    bool m_gaveUp = false;                 // Restart limit reached
+    Clock::time_point m_nextStart;         // Earliest time for the next restart
+    std::deque<Clock::time_point> m_recentRestarts;
+    std::atomic<size_t> m_restarts{0};
+};
+
+// Stands in for a node that runs in a worker process: the Linker routes to it
+// like to any other node, and every push becomes a request to the worker.
+class RemoteNode : public Node {
+public:
+    explicit RemoteNode(std::shared_ptr<WorkerProcess> worker);
+
+    const std::string& getId() const override { return m_id; }
+    bool push(nlohmann::json data) override;
+    bool pushMessage(Message message) override;
+    const nlohmann::json& pull() override { return m_data_out; }
+
+private:
+    std::shared_ptr<WorkerProcess> m_worker;
+};
+
+// Watches every worker process (Singleton): restarts workers that exited and
+// shuts them all down when the program ends.
+class WorkerSupervisor {
+public:
+    static WorkerSupervisor& getInstance();
+
+    // Delete copy constructor and assignment operator for Singleton
+    WorkerSupervisor(const WorkerSupervisor&) = delete;
+    WorkerSupervisor& operator=(const WorkerSupervisor&) = delete;
+
+    // Starts a worker for nodeId and watches it. The worker is watched even if
+    // the first start fails, so it is retried.
+    std::shared_ptr<WorkerProcess> launch(const std::string& nodeId, const WorkerConfig& config);
+    // Stops every worker and the watcher.
+    void shutdown();
+
+private:
+    WorkerSupervisor() = default;
+    ~WorkerSupervisor();
+
+    void watch();
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+    std::vector<std::shared_ptr<WorkerProcess>> m_workers;
+    std::thread m_watcher; // Started with the first worker
+};
+
+#endif // WORKER_PROCESS_H